@@ -25,6 +25,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #define _GPRMC_TERM   "GPRMC"
 #define _GPGGA_TERM   "GPGGA"
+#ifndef _GPS_NO_EXTENDED
+#define _GPGSA_TERM   "GPGSA"
+#define _GPGSV_TERM   "GPGSV"
+#define _GPZDA_TERM   "GPZDA"
+#endif
 
 TinyGPS::TinyGPS()
   :  _time(GPS_INVALID_TIME)
@@ -38,6 +43,16 @@ TinyGPS::TinyGPS()
   ,  _numsats(GPS_INVALID_SATELLITES)
   ,  _last_time_fix(GPS_INVALID_FIX_TIME)
   ,  _last_position_fix(GPS_INVALID_FIX_TIME)
+#ifndef _GPS_NO_EXTENDED
+  ,  _fix_mode(GPS_INVALID_FIX_MODE)
+  ,  _pdop(GPS_INVALID_HDOP)
+  ,  _vdop(GPS_INVALID_HDOP)
+  ,  _sats_in_view(0)
+  ,  _gsv_next(0)
+  ,  _zda_time(GPS_INVALID_TIME)
+  ,  _zda_date(GPS_INVALID_DATE)
+  ,  _last_zda_fix(GPS_INVALID_FIX_TIME)
+#endif
   ,  _parity(0)
   ,  _is_checksum_term(false)
   ,  _sentence_type(_GPS_SENTENCE_OTHER)
@@ -175,12 +190,12 @@ bool TinyGPS::term_complete()
 #ifndef _GPS_NO_STATS
         ++_good_sentences;
 #endif
-        _last_time_fix = _new_time_fix;
-        _last_position_fix = _new_position_fix;
 
         switch(_sentence_type)
         {
         case _GPS_SENTENCE_GPRMC:
+          _last_time_fix = _new_time_fix;
+          _last_position_fix = _new_position_fix;
           _time      = _new_time;
           _date      = _new_date;
           _latitude  = _new_latitude;
@@ -189,6 +204,8 @@ bool TinyGPS::term_complete()
           _course    = _new_course;
           break;
         case _GPS_SENTENCE_GPGGA:
+          _last_time_fix = _new_time_fix;
+          _last_position_fix = _new_position_fix;
           _altitude  = _new_altitude;
           _time      = _new_time;
           _latitude  = _new_latitude;
@@ -196,6 +213,30 @@ bool TinyGPS::term_complete()
           _numsats   = _new_numsats;
           _hdop      = _new_hdop;
           break;
+#ifndef _GPS_NO_EXTENDED
+        case _GPS_SENTENCE_GPGSA:
+          _fix_mode  = _new_fix_mode;
+          _pdop      = _new_pdop;
+          _vdop      = _new_vdop;
+          break;
+        case _GPS_SENTENCE_GPGSV:
+          // publish only when the last sentence of an unbroken set arrives
+          if (_gsv_number < _gsv_total)
+          {
+            _gsv_next = _gsv_number + 1;
+            return false;
+          }
+          _gsv_next = 0;
+          _sats_in_view = _new_sats_in_view;
+          memcpy(_sat_prn, _new_sat_prn, sizeof(_sat_prn));
+          memcpy(_sat_snr, _new_sat_snr, sizeof(_sat_snr));
+          break;
+        case _GPS_SENTENCE_GPZDA:
+          _last_zda_fix = _new_zda_fix;
+          _zda_time  = _new_zda_time;
+          _zda_date  = _new_zda_date;
+          break;
+#endif
         }
 
         return true;
@@ -205,6 +246,10 @@ bool TinyGPS::term_complete()
 #ifndef _GPS_NO_STATS
     else
       ++_failed_checksum;
+#endif
+#ifndef _GPS_NO_EXTENDED
+    if (_sentence_type == _GPS_SENTENCE_GPGSV)
+      _gsv_next = 0;
 #endif
     return false;
   }
@@ -216,11 +261,40 @@ bool TinyGPS::term_complete()
       _sentence_type = _GPS_SENTENCE_GPRMC;
     else if (!gpsstrcmp(_term, _GPGGA_TERM))
       _sentence_type = _GPS_SENTENCE_GPGGA;
+#ifndef _GPS_NO_EXTENDED
+    else if (!gpsstrcmp(_term, _GPGSA_TERM))
+      _sentence_type = _GPS_SENTENCE_GPGSA;
+    else if (!gpsstrcmp(_term, _GPGSV_TERM))
+      _sentence_type = _GPS_SENTENCE_GPGSV;
+    else if (!gpsstrcmp(_term, _GPZDA_TERM))
+      _sentence_type = _GPS_SENTENCE_GPZDA;
+#endif
     else
       _sentence_type = _GPS_SENTENCE_OTHER;
+#ifndef _GPS_NO_EXTENDED
+    // these carry no validity flag of their own
+    _gps_data_good = _sentence_type == _GPS_SENTENCE_GPGSA
+      || _sentence_type == _GPS_SENTENCE_GPGSV || _sentence_type == _GPS_SENTENCE_GPZDA;
+#endif
     return false;
   }
 
+#ifndef _GPS_NO_EXTENDED
+  // GPGSV satellites come in groups of PRN, elevation, azimuth and SNR, any of which may be empty
+  if (_sentence_type == _GPS_SENTENCE_GPGSV && _term_number >= 4)
+  {
+    byte i = 4 * (_gsv_number - 1) + (_term_number - 4) / 4;
+    if (i < _GPS_MAX_SATS)
+    {
+      if ((_term_number - 4) % 4 == 0)
+        _new_sat_prn[i] = (byte)gpsatol(_term);
+      else if ((_term_number - 4) % 4 == 3)
+        _new_sat_snr[i] = (byte)gpsatol(_term);
+    }
+    return false;
+  }
+#endif
+
   if (_sentence_type != _GPS_SENTENCE_OTHER && _term[0])
     switch(COMBINE(_sentence_type, _term_number))
   {
@@ -272,6 +346,46 @@ bool TinyGPS::term_complete()
     case COMBINE(_GPS_SENTENCE_GPGGA, 9): // Altitude (GPGGA)
       _new_altitude = parse_decimal();
       break;
+#ifndef _GPS_NO_EXTENDED
+    case COMBINE(_GPS_SENTENCE_GPGSA, 2): // Fix mode (GPGSA)
+      _new_fix_mode = (byte)gpsatol(_term);
+      break;
+    case COMBINE(_GPS_SENTENCE_GPGSA, 15): // PDOP (GPGSA)
+      _new_pdop = parse_decimal();
+      break;
+    case COMBINE(_GPS_SENTENCE_GPGSA, 17): // VDOP (GPGSA)
+      _new_vdop = parse_decimal();
+      break;
+    case COMBINE(_GPS_SENTENCE_GPGSV, 1): // Number of sentences in set (GPGSV)
+      _gsv_total = (byte)gpsatol(_term);
+      break;
+    case COMBINE(_GPS_SENTENCE_GPGSV, 2): // Sentence number (GPGSV)
+      _gsv_number = (byte)gpsatol(_term);
+      if (_gsv_number == 1)
+      {
+        memset(_new_sat_prn, 0, sizeof(_new_sat_prn));
+        memset(_new_sat_snr, 0, sizeof(_new_sat_snr));
+      }
+      else if (_gsv_number != _gsv_next)
+        _gps_data_good = false;
+      break;
+    case COMBINE(_GPS_SENTENCE_GPGSV, 3): // Satellites in view (GPGSV)
+      _new_sats_in_view = (byte)gpsatol(_term);
+      break;
+    case COMBINE(_GPS_SENTENCE_GPZDA, 1): // Time (GPZDA)
+      _new_zda_time = parse_decimal();
+      _new_zda_fix = millis();
+      break;
+    case COMBINE(_GPS_SENTENCE_GPZDA, 2): // Day (GPZDA)
+      _new_zda_date = 10000UL * gpsatol(_term);
+      break;
+    case COMBINE(_GPS_SENTENCE_GPZDA, 3): // Month (GPZDA)
+      _new_zda_date += 100UL * gpsatol(_term);
+      break;
+    case COMBINE(_GPS_SENTENCE_GPZDA, 4): // Year (GPZDA), kept as yy to match GPRMC
+      _new_zda_date += gpsatol(_term) % 100;
+      break;
+#endif
   }
 
   return false;
@@ -365,6 +479,26 @@ void TinyGPS::get_datetime(unsigned long *date, unsigned long *time, unsigned lo
    GPS_INVALID_AGE : millis() - _last_time_fix;
 }
 
+#ifndef _GPS_NO_EXTENDED
+bool TinyGPS::satellite(byte i, byte *prn, byte *snr)
+{
+  if (i >= _GPS_MAX_SATS || i >= _sats_in_view)
+    return false;
+  if (prn) *prn = _sat_prn[i];
+  if (snr) *snr = _sat_snr[i];
+  return true;
+}
+
+// date as ddmmyy, time as hhmmsscc, and age in milliseconds from last GPZDA
+void TinyGPS::get_zda_datetime(unsigned long *date, unsigned long *time, unsigned long *age)
+{
+  if (date) *date = _zda_date;
+  if (time) *time = _zda_time;
+  if (age) *age = _last_zda_fix == GPS_INVALID_FIX_TIME ? 
+   GPS_INVALID_AGE : millis() - _last_zda_fix;
+}
+#endif
+
 void TinyGPS::f_get_position(float *latitude, float *longitude, unsigned long *fix_age)
 {
   long lat, lon;
@@ -39,6 +39,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define _GPS_MILES_PER_METER 0.00062137112
 #define _GPS_KM_PER_METER 0.001
 // #define _GPS_NO_STATS
+// #define _GPS_NO_EXTENDED    // define to skip GPGSA, GPGSV and GPZDA decoding
+#define _GPS_MAX_SATS 16      // most satellites kept from GPGSV
 
 class TinyGPS
 {
@@ -48,7 +50,7 @@ public:
     GPS_INVALID_ALTITUDE = 999999999,  GPS_INVALID_DATE = 0,
     GPS_INVALID_TIME = 0xFFFFFFFF,		 GPS_INVALID_SPEED = 999999999, 
     GPS_INVALID_FIX_TIME = 0xFFFFFFFF, GPS_INVALID_SATELLITES = 0xFF,
-    GPS_INVALID_HDOP = 0xFFFFFFFF
+    GPS_INVALID_HDOP = 0xFFFFFFFF,      GPS_INVALID_FIX_MODE = 0
   };
 
   static const float GPS_INVALID_F_ANGLE, GPS_INVALID_F_ALTITUDE, GPS_INVALID_F_SPEED;
@@ -99,8 +101,31 @@ public:
   void stats(unsigned long *chars, unsigned short *good_sentences, unsigned short *failed_cs);
 #endif
 
+#ifndef _GPS_NO_EXTENDED
+  // fix mode in last GPGSA sentence: 1 none, 2 2D, 3 3D
+  inline byte fix_mode() { return _fix_mode; }
+
+  // position and vertical dilution of precision in last GPGSA sentence in 100ths
+  inline unsigned long pdop() { return _pdop; }
+  inline unsigned long vdop() { return _vdop; }
+
+  // satellites in view in last complete set of GPGSV sentences
+  inline byte satellites_in_view() { return _sats_in_view; }
+
+  // PRN and SNR in dB-Hz of the i'th satellite in view, SNR is 0 when not tracked.
+  // returns false if i is beyond those kept.
+  bool satellite(byte i, byte *prn, byte *snr);
+
+  // date as ddmmyy, time as hhmmsscc, and age in milliseconds from last GPZDA sentence
+  void get_zda_datetime(unsigned long *date, unsigned long *time, unsigned long *age = 0);
+#endif
+
 private:
-  enum {_GPS_SENTENCE_GPGGA, _GPS_SENTENCE_GPRMC, _GPS_SENTENCE_OTHER};
+  enum {_GPS_SENTENCE_GPGGA, _GPS_SENTENCE_GPRMC,
+#ifndef _GPS_NO_EXTENDED
+    _GPS_SENTENCE_GPGSA, _GPS_SENTENCE_GPGSV, _GPS_SENTENCE_GPZDA,
+#endif
+    _GPS_SENTENCE_OTHER};
 
   // properties
   unsigned long _time, _new_time;
@@ -116,6 +141,19 @@ private:
   unsigned long _last_time_fix, _new_time_fix;
   unsigned long _last_position_fix, _new_position_fix;
 
+#ifndef _GPS_NO_EXTENDED
+  byte _fix_mode, _new_fix_mode;
+  unsigned long _pdop, _new_pdop;
+  unsigned long _vdop, _new_vdop;
+  byte _sats_in_view, _new_sats_in_view;
+  byte _sat_prn[_GPS_MAX_SATS], _new_sat_prn[_GPS_MAX_SATS];
+  byte _sat_snr[_GPS_MAX_SATS], _new_sat_snr[_GPS_MAX_SATS];
+  byte _gsv_total, _gsv_number, _gsv_next;
+  unsigned long _zda_time, _new_zda_time;
+  unsigned long _zda_date, _new_zda_date;
+  unsigned long _last_zda_fix, _new_zda_fix;
+#endif
+
   // parsing state variables
   byte _parity;
   bool _is_checksum_term;
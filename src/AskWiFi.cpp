@@ -24,15 +24,15 @@ void Webpage::askWiFi()
 	delay(200);
 	WiFi.mode(WIFI_AP);
 	if (!WiFi.softAPConfig(ip, gw, nm)) {
-	    Serial.println ("Can not configure softAP");
+	    DEBUG_SERIAL.println ("Can not configure softAP");
 	    return;
 	}
 	if (!WiFi.softAP (ssid)) {
-	    Serial.println ("Can not set AP ssid");
+	    DEBUG_SERIAL.println ("Can not set AP ssid");
 	    return;
 	}
 	delay(500);
-	Serial.print (F("AP IP: ")); Serial.println (WiFi.softAPIP());
+	DEBUG_SERIAL.print (F("AP IP: ")); DEBUG_SERIAL.println (WiFi.softAPIP());
 
 	// start HTTP server 
 	resetWatchdog();
@@ -51,14 +51,14 @@ void Webpage::askWiFi()
 
 	    // listen for a connection
 	    WiFiClient remoteClient;
-	    Serial.println ("waiting for client");
+	    DEBUG_SERIAL.println ("waiting for client");
 	    dns.processNextRequest();
 	    do {
 		resetWatchdog();
 		delay(100);
 		remoteClient = remoteServer.available();
 	    } while (!remoteClient);
-	    Serial.print (F("client connected from ")); Serial.println (remoteClient.remoteIP());
+	    DEBUG_SERIAL.print (F("client connected from ")); DEBUG_SERIAL.println (remoteClient.remoteIP());
 
 	    // send the WiFI setup page
 	    sendAskPage (remoteClient);
@@ -88,12 +88,12 @@ void Webpage::askWiFi()
 		}
 	    }
 	    remoteClient.stop();
-	    Serial.println (line);
+	    DEBUG_SERIAL.println (line);
 
 	    // abort if no GET
 	    if (!GET) {
-		Serial.println (line);
-		Serial.println ("No GET");
+		DEBUG_SERIAL.println (line);
+		DEBUG_SERIAL.println ("No GET");
 		break;
 	    }
 
@@ -115,7 +115,7 @@ void Webpage::askWiFi()
 		    *eos = '\0';
 		    strncpy (nv->ssid, wifi_id, sizeof(nv->ssid));
 		    nv->put();
-		    Serial.println(nv->ssid);
+		    DEBUG_SERIAL.println(nv->ssid);
 		    n_info++;
 		}
 	    }
@@ -126,7 +126,7 @@ void Webpage::askWiFi()
 		    *eos = '\0';
 		    strncpy (nv->pw, wifi_pw, sizeof(nv->pw));
 		    nv->put();
-		    Serial.println(nv->pw);
+		    DEBUG_SERIAL.println(nv->pw);
 		    n_info++;
 		}
 	    }
@@ -137,7 +137,7 @@ void Webpage::askWiFi()
 		    *eos = '\0';
 		    nv->IP.fromString (wifi_ip);
 		    nv->put();
-		    Serial.println(nv->IP.toString());
+		    DEBUG_SERIAL.println(nv->IP.toString());
 		    n_info++;
 		}
 	    }
@@ -148,7 +148,7 @@ void Webpage::askWiFi()
 		    *eos = '\0';
 		    nv->NM.fromString (wifi_nm);
 		    nv->put();
-		    Serial.println(nv->NM.toString());
+		    DEBUG_SERIAL.println(nv->NM.toString());
 		    n_info++;
 		}
 	    }
@@ -159,7 +159,7 @@ void Webpage::askWiFi()
 		    *eos = '\0';
 		    nv->GW.fromString (wifi_gw);
 		    nv->put();
-		    Serial.println(nv->GW.toString());
+		    DEBUG_SERIAL.println(nv->GW.toString());
 		    n_info++;
 		}
 	    }
@@ -1,10 +1,26 @@
 #ifndef __AST_H
 #define __AST_H
 
+// define to read the GPS with the hardware UART swapped to GPIO13 (RX) and GPIO15 (TX) instead
+// of bit-banging it with SoftwareSerial. debug output then moves to Serial1, TX only on GPIO2.
+// #define GPS_HWSERIAL
+
+// where debug output goes, never the UART the GPS is on
+#if defined(GPS_HWSERIAL)
+#define DEBUG_SERIAL	Serial1
+#else
+#define DEBUG_SERIAL	Serial
+#endif
+
 extern void resetWatchdog();
 
 extern double myfmod (double a, double n);
 extern double myatof (const char *s);
 
+// one point on the predicted sky path of a pass, degs
+typedef struct {
+    float az, el;
+} SkyPoint;
+
 
 #endif // __AST_H
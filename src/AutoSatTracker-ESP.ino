@@ -3,6 +3,7 @@
  * Connections on Adafruit ESP8266 Huzzah:
  *   Servo controller connects to SDA and SCL
  *   GPS TX connects to 16, RX to 2
+ *   GPS PPS connects to 14, optional
  *
  */
 
@@ -13,6 +14,7 @@
 #include "Circum.h"
 #include "Gimbal.h"
 #include "Target.h"
+#include "Control.h"
 #include "Webpage.h"
 
 NV *nv;
@@ -20,6 +22,7 @@ Sensor *sensor;
 Circum *circum;
 Gimbal *gimbal;
 Target *target;
+Control *control;
 Webpage *webpage;
 
 /* called first and once
@@ -28,7 +31,7 @@ void
 setup()
 {
     // init serial monitor
-    Serial.begin (115200);
+    DEBUG_SERIAL.begin (115200);
     delay(500);
 
     // this just resets the soft timeout, the hard timeout is still 6 seconds
@@ -36,32 +39,34 @@ setup()
 
     // scan for I2C devices
     resetWatchdog();
-    Serial.println();
-    Serial.print (F("Scanning I2C:"));
+    DEBUG_SERIAL.println();
+    DEBUG_SERIAL.print (F("Scanning I2C:"));
     for (uint8_t a = 1; a < 127; a++) {
 	Wire.beginTransmission(a);
 	if (Wire.endTransmission() == 0) {
-	    Serial.print (' '); Serial.print (a, HEX);
+	    DEBUG_SERIAL.print (' '); DEBUG_SERIAL.print (a, HEX);
 	}
     }
-    Serial.println();
+    DEBUG_SERIAL.println();
 
     // instantiate each module
-    Serial.println (F("making NV"));
+    DEBUG_SERIAL.println (F("making NV"));
     nv = new NV();
-    Serial.println (F("making Sensor"));
+    DEBUG_SERIAL.println (F("making Sensor"));
     sensor = new Sensor();
-    Serial.println (F("making Circum"));
+    DEBUG_SERIAL.println (F("making Circum"));
     circum = new Circum();
-    Serial.println (F("making Gimbal"));
+    DEBUG_SERIAL.println (F("making Gimbal"));
     gimbal = new Gimbal();
-    Serial.println (F("making Target"));
+    DEBUG_SERIAL.println (F("making Target"));
     target = new Target();
-    Serial.println (F("making Webpage"));
+    DEBUG_SERIAL.println (F("making Control"));
+    control = new Control();
+    DEBUG_SERIAL.println (F("making Webpage"));
     webpage = new Webpage();
 
     // all set to go.. see you in loop()
-    Serial.println (F("Ready"));
+    DEBUG_SERIAL.println (F("Ready"));
 
 }
 
@@ -76,8 +81,14 @@ loop()
     // check for new GPS info
     circum->checkGPS();
 
-    // follow the target
-    target->track();
+    // get time from the network until GPS locks
+    circum->checkNTP();
+
+    // catch up with any changes to time, place or target
+    circum->checkRecompute();
+
+    // sense, estimate and follow the target, each at its own rate
+    control->run();
 }
 
 void
@@ -5,12 +5,68 @@
 #include "Circum.h"
 
 // serial configuration for GPS
-#define	GPS_TX_PIN	13			// not needed
+#define	GPS_TX_PIN	13			// only used to send PMTK configuration
 #define	GPS_RX_PIN	12
 #define	GPS_INVERT	false
 #define	GPS_BUFSIZE	512
+#define	GPS_HWBUFSIZE	1024			// UART ring buffer when GPS_HWSERIAL
+#define	GPS_CHUNK	16			// bytes moved from serial buffer per read
 #define	GPS_BAUD	9600
+#define	GPS_PPS_PIN	14			// GPS PPS output, rising edge at each UTC second
+#define	GPS_MAX_BYTES	64			// max bytes to parse per checkGPS()
+#define	GPS_MAX_US	2000			// max time to spend parsing per checkGPS(), us
+#define	GPS_JIT_ANGLE	10000L			// location change to ignore, millionths of a degree
+#define	GPS_JIT_ALT	10000L			// altitude change to ignore, cm
 
+// MTK receiver configuration
+#if defined(_GPS_NO_EXTENDED)
+#define	GPS_SENTENCES	"PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"	// RMC and GGA only
+#else
+#define	GPS_SENTENCES	"PMTK314,0,1,0,1,1,5,0,0,0,0,0,0,0,0,0,0,0,1,0"	// also GSA, ZDA, GSV each 5th
+#endif
+#define	GPS_FIX_MS	1000			// fix interval, ms
+// #define GPS_FAST_BAUD	38400			// define to raise MTK receiver baud rate
+#define	PMTK_ACK_MS	1000			// max wait for PMTK_ACK, ms
+#define	UBX_ACK_MS	1000			// max wait for UBX ACK-ACK, ms
+
+// PPS discipline
+#define	PPS_MAXERR	500			// max PPS interval error to accept, us
+#define	PPS_TIMEOUT	1500			// PPS lock is lost after this long without a pulse, ms
+#define	PPS_TAU		16			// smoothing time constant, pulses
+
+// holdover
+#define	GPS_STALE	2000			// fix older than this is not used to set time, ms
+#define	GPS_AGE_MS	250			// how often to age the fix when no sentence completes, ms
+#define	NMEA_UNC	0.5F			// time uncertainty when set from NMEA alone, secs
+#define	HOLD_START	3.0F			// holdover starts this long after last sync, secs
+#define	DRIFT_BASE_MIN	600			// min baseline before trusting learned drift, secs
+#define	DRIFT_BASE_MAX	86400L			// restart baseline after this long to follow aging, secs
+#define	DRIFT_WANDER	1e-6F			// allowance for drift change since learned, fraction
+#define	DRIFT_UNKNOWN	50e-6F			// assumed drift before any is learned, fraction
+#define	TIME_UNC_MAX	1.0F			// predictions are suspect beyond this uncertainty, secs
+
+// SNTP fallback
+#define	NTP_SERVER	"pool.ntp.org"		// SNTP server host name
+#define	NTP_PORT	123			// SNTP server port
+#define	NTP_LOCAL_PORT	2390			// our port for replies
+#define	NTP_PKTLEN	48			// SNTP packet length
+#define	NTP_TIMEOUT	2000			// give up waiting for a reply, ms
+#define	NTP_RETRY	10000			// wait after a failure before trying again, ms
+#define	NTP_DNS_MS	1000			// max time to block resolving NTP_SERVER, ms
+#define	NTP_REDNS	4			// resolve again after this many requests time out
+#define	NTP_POLL	900000L			// refresh interval while GPS is not locked, ms
+#define	NTP_UNIX	2208988800UL		// NTP seconds at 1970 Jan 1
+
+/* PPS interrupt just records when the pulse arrived, all processing is done in checkPPS()
+ */
+static volatile uint32_t pps_us;		// micros() at most recent PPS edge
+static volatile uint32_t pps_n;			// count of PPS edges
+
+static void ICACHE_RAM_ATTR onPPS()
+{
+	pps_us = micros();
+	pps_n++;
+}
 
 /* constructor
  */
@@ -18,25 +74,75 @@ Circum::Circum ()
 {
 	// create serial connection to GPS board
 	resetWatchdog();
-	//ss = new SoftwareSerial (GPS_RX_PIN, GPS_TX_PIN, GPS_INVERT, GPS_BUFSIZE);
-	//ss->begin(GPS_BAUD);
-  ss = new SoftwareSerial ();
-  ss->begin(GPS_BAUD, GPS_RX_PIN, GPS_TX_PIN, SWSERIAL_8N1, false, 512);
-  
+#if defined(GPS_HWSERIAL)
+	// UART RX is filled by the FIFO interrupt, not per bit. Swap moves it to GPIO13/15, off USB.
+	DEBUG_SERIAL.println (F("GPS moving to hardware UART on GPIO13/15"));
+	Serial.setRxBufferSize (GPS_HWBUFSIZE);
+	Serial.begin (GPS_BAUD);
+	Serial.swap();
+	ss = &Serial;
+#else
+	ss = new SoftwareSerial ();
+	ss->begin(GPS_BAUD, GPS_RX_PIN, GPS_TX_PIN, SWSERIAL_8N1, GPS_INVERT, GPS_BUFSIZE);
+#endif
+	gps_overruns = 0;
+
 	// create GPS parser
 	resetWatchdog();
-	GPS = new TinyGPS();
+	GPS = new GPSParser();
+
+	// trim receiver output to just what we use
+	gps_bytes = 0;
+	gps_bps = 0;
+	gps_bps_m0 = millis();
+#if !defined(GPS_UBX)
+	pmtk_n = 0;
+#endif
+	gps_configured = configGPS();
+
+	// listen for PPS, if connected
+	clk_drift = 0;
+	clk_offset = 0;
+	clk_jitter = 0;
+	pps_lock = false;
+	pps_seen = 0;
+	pps_prev = 0;
+	pinMode (GPS_PPS_PIN, INPUT_PULLUP);		// quiet if not connected
+	attachInterrupt (digitalPinToInterrupt(GPS_PPS_PIN), onPPS, RISING);
+
+	// nothing learned yet
+	ever_synced = false;
+	sync_us = ref_us = 0;
+	sync_unc = ref_unc = 0;
+	ref_DN = ref_S = 0;
+	hold_drift = hold_sigma = 0;
+	hold_learned = false;
 
 	// init values
 	resetWatchdog();
 	latitude = 30.0;
 	longitude = -110.0;
 	altitude = 700.0;
-	obs = NULL;
-	newObserver (latitude, longitude, altitude);
+	updateObserver (latitude, longitude, altitude);
 	hdop = 99.0;
 	nsats = 0;
-	setnow (2018, 1, 1, 0, 0, 0);
+	gps_lat = gps_lng = GPSParser::GPS_INVALID_ANGLE;
+	gps_alt = GPSParser::GPS_INVALID_ALTITUDE;
+	gps_hdop = GPSParser::GPS_INVALID_HDOP;
+	gps_parseus = 0;
+	memset (&cal, 0, sizeof(cal));
+	cal.DN = cal.S = -1;
+	setnow (2018, 1, 1, 0, 0, 0, micros64());
+	time_src = TS_NONE;
+
+	// SNTP starts once WiFi is up
+	ntp_resolved = false;
+	ntp_ready = false;
+	ntp_waiting = false;
+	ntp_fails = 0;
+	ntp_m0 = millis();
+	ntp_interval = 0;
+	ntp_rtt = -1;
 	magdecl (latitude, longitude, altitude, decimalYear(), &magdeclination);
 
 	// init flags
@@ -45,25 +151,95 @@ Circum::Circum ()
 	time_overridden = false;
 	loc_overridden = false;
 
+	// no GPS work measured yet
+	gps_maxus = 0;
+	gps_age_m0 = millis();
+
+	// nothing to recompute yet
+	rc_pending = 0;
+	rc_m0 = rc_first = 0;
+	rc_requests = 0;
+	rc_runs = 0;
+
 }
 
 /* return current time as a decimal year
  */
 float Circum::decimalYear()
 {
-	// get time now, sets dt_now.DN and dt_now.TN
+	// get time now, sets dt_now.DN and dt_now.TN and cal
 	int year; uint8_t month, day, h, m, s;
 	getnow (year, month, day, h, m, s);
 
-	// get time on jan 1 this year
-	DateTime y0 (year, 1, 1, 0, 0, 0);
-
 	// n days this year
 	int nd = (year%4) ? 365 : 366;
 
 	// return year and fraction
-	return (year + ((dt_now.DN + dt_now.TN) - (y0.DN + y0.TN))/nd);
+	return (year + ((dt_now.DN - cal.y0DN) + dt_now.TN)/nd);
+}
+
+#if !defined(_GPS_NO_EXTENDED)
+/* send the fix quality values only available from GSA, GSV and ZDA.
+ */
+void Circum::sendExtendedValues (WiFiClient client)
+{
+	client.print (F("GPS_FixMode="));
+	switch (GPS->fix_mode()) {
+	case 2:
+	    client.println (F("2D!"));
+	    break;
+	case 3:
+	    client.println (F("3D"));
+	    break;
+	default:
+	    client.println (F("None!"));
+	    break;
+	}
+
+	client.print (F("GPS_PDOP="));
+	if (GPS->pdop() == GPSParser::GPS_INVALID_HDOP)
+	    client.println (F("?"));
+	else
+	    client.println (0.01F*GPS->pdop());
+	client.print (F("GPS_VDOP="));
+	if (GPS->vdop() == GPSParser::GPS_INVALID_HDOP)
+	    client.println (F("?"));
+	else
+	    client.println (0.01F*GPS->vdop());
+
+	// strongest and mean SNR of those being tracked
+	uint8_t prn, snr, best = 0;
+	uint16_t sum = 0, ntracked = 0;
+	for (uint8_t i = 0; GPS->satellite (i, &prn, &snr); i++) {
+	    if (snr > 0) {
+		sum += snr;
+		ntracked++;
+		if (snr > best)
+		    best = snr;
+	    }
+	}
+	client.print (F("GPS_InView=")); client.println (GPS->satellites_in_view());
+	client.print (F("GPS_SNR="));
+	if (ntracked > 0) {
+	    client.print (best);
+	    client.print (F(" / "));
+	    client.println (sum/ntracked);
+	} else
+	    client.println (F("None!"));
+
+	// ZDA time to the hundredth, if it is current
+	unsigned long zdate, ztime, zage;
+	GPS->get_zda_datetime (&zdate, &ztime, &zage);
+	client.print (F("GPS_ZDA="));
+	if (zage > GPS_STALE)
+	    client.println (F("None"));
+	else {
+	    printHMS (client, ztime/1000000, (ztime/10000)%100, (ztime/100)%100);
+	    client.print ((ztime%100) < 10 ? F(".0") : F("."));
+	    client.println (ztime%100);
+	}
 }
+#endif
 
 /* send latest values to web page.
  * N.B. names must match ids in web page
@@ -83,7 +259,9 @@ void Circum::sendNewValues (WiFiClient client)
 	    printPL (client, time_overridden ? BADNEWS : NORMAL);
 
 	client.print (F("GPS_Status="));
-	if (gps_lock) {
+	if (inHoldover() && !time_overridden) {
+	    client.println (F("Holdover!"));
+	} else if (gps_lock) {
 	    if (time_overridden || loc_overridden)
 		client.println (F("Overridden!"));
 	    else
@@ -109,6 +287,54 @@ void Circum::sendNewValues (WiFiClient client)
 	client.print (F("GPS_MagDecl=")); client.println (magdeclination);
 	client.print (F("GPS_HDOP=")); client.println (hdop);
 	client.print (F("GPS_NSat=")); client.println (nsats);
+#if !defined(_GPS_NO_EXTENDED)
+	sendExtendedValues (client);
+#endif
+	client.print (F("GPS_RCSaved=")); client.println (rc_requests - rc_runs);
+	client.print (F("GPS_MaxUs=")); client.println (gps_maxus);
+	client.print (F("GPS_Bps=")); client.print (gps_bps);
+	    printPL (client, gps_configured ? NORMAL : BADNEWS);
+	client.print (F("GPS_Drops=")); client.print (gps_overruns);
+	    printPL (client, gps_overruns > 0 ? BADNEWS : NORMAL);
+	client.print (F("GPS_ParseUs=")); client.println (gps_parseus);
+
+	client.print (F("GPS_ClkOff="));
+	if (pps_lock)
+	    client.println (clk_offset, 1);
+	else
+	    client.println (F("No PPS"));
+	client.print (F("GPS_ClkJit="));
+	if (pps_lock)
+	    client.println (clk_jitter, 1);
+	else
+	    client.println (F(""));
+	client.print (F("GPS_ClkDrift=")); client.println (1e6*clk_drift, 2);
+
+	client.print (F("GPS_TimeUnc="));
+	if (ever_synced || time_overridden) {
+	    client.print (timeUncertainty(), 3);
+	    printPL (client, timeSuspect() ? BADNEWS : NORMAL);
+	} else
+	    client.println (F("Unknown!"));
+	client.print (F("GPS_HoldDrift="));
+	if (hold_learned)
+	    client.println (1e6*hold_drift, 2);
+	else
+	    client.println (F("Learning"));
+
+	client.print (F("GPS_TimeSrc="));
+	switch (time_src) {
+	case TS_OP:  client.println (F("Operator!")); break;
+	case TS_NTP: client.println (F("NTP")); break;
+	case TS_GPS: client.println (F("GPS")); break;
+	case TS_PPS: client.println (F("GPS+PPS+")); break;
+	default:     client.println (F("None!")); break;
+	}
+	client.print (F("GPS_NTPRtt="));
+	if (ntp_rtt >= 0)
+	    client.println (ntp_rtt, 1);
+	else
+	    client.println (F("-"));
 }
 
 /* print value v in sexagesimal format, can be negative
@@ -193,11 +419,10 @@ bool Circum::overrideValue (char *name, char *value)
 		if (sat != mat)				// if new seconds ...
 		    s = strtol (sat, NULL, 10);		// override seconds
 	    }
-	    setnow (year, month, day, h, m, s);		// set system time to new value
+	    setnow (year, month, day, h, m, s, micros64());	// set system time to new value
 	    time_overridden = true;			// set flag that op has overridden GPS time
-	    target->updateTopo();			// update target to new time
-	    target->findNextPass();			// update pass from now
-	    target->computeSkyPath();			// and show
+	    time_src = TS_OP;
+	    requestRecompute (RC_PASS);			// update pass from now
 	    return (true);
 	}
 	if (!strcmp (name, "GPS_Date")) {
@@ -211,137 +436,760 @@ bool Circum::overrideValue (char *name, char *value)
 		if (dat != mat)				// if new day ...
 		    day = strtol (dat, NULL, 10);	// override day
 	    }
-	    setnow (year, month, day, h, m, s);		// set system time to new value
+	    setnow (year, month, day, h, m, s, micros64());	// set system time to new value
 	    time_overridden = true;			// set flag that op has overridden GPS time
-	    target->updateTopo();			// update target to new time
-	    target->findNextPass();			// update pass from now
-	    target->computeSkyPath();			// and show
+	    time_src = TS_OP;
+	    requestRecompute (RC_PASS);			// update pass from now
 	    return (true);
 	}
 	if (!strcmp (name, "GPS_Lat")) {
 	    latitude = atof (value);
-	    newObserver (latitude, longitude, altitude);
 	    loc_overridden = true;			// set flag that op has overridden GPS loc
-	    target->updateTopo();			// update target to new time
-	    target->findNextPass();			// update pass from here
-	    target->computeSkyPath();			// and show
-	    magdecl (latitude, longitude, altitude, decimalYear(), &magdeclination);
+	    requestRecompute (RC_OBSERVER|RC_PASS);	// update place and pass from here
 	    return (true);
 	}
 	if (!strcmp (name, "GPS_Long")) {
 	    longitude = atof (value);
-	    newObserver (latitude, longitude, altitude);
 	    loc_overridden = true;			// set flag that op has overridden GPS loc
-	    target->updateTopo();			// update target to new time
-	    target->findNextPass();			// update pass from here
-	    target->computeSkyPath();			// and show
-	    magdecl (latitude, longitude, altitude, decimalYear(), &magdeclination);
+	    requestRecompute (RC_OBSERVER|RC_PASS);	// update place and pass from here
 	    return (true);
 	}
 	if (!strcmp (name, "GPS_Alt")) {
 	    altitude = atof (value);
-	    newObserver (latitude, longitude, altitude);
 	    loc_overridden = true;			// set flag that op has overridden GPS loc
-	    target->updateTopo();			// update target to new time
-	    target->findNextPass();			// update pass from here
-	    target->computeSkyPath();			// and show
-	    magdecl (latitude, longitude, altitude, decimalYear(), &magdeclination);
+	    requestRecompute (RC_OBSERVER|RC_PASS);	// update place and pass from here
 	    return (true);
 	}
 	if (!strcmp (name, "GPS_Enable")) {
 	    time_overridden = false;			// resume GPS values
 	    loc_overridden = false;			// resume GPS values
+	    gps_lat = GPSParser::GPS_INVALID_ANGLE;	// insure next fix replaces op's location
 	}
 
 	return (false);	// not one of ours
 }
 
+/* note that the given RC_* work is needed, it will be performed by checkRecompute() once
+ * requests stop arriving so several related changes cost only one pass search.
+ */
+void Circum::requestRecompute (uint8_t what)
+{
+	if (!rc_pending)
+	    rc_first = millis();
+	rc_pending |= what;
+	rc_m0 = millis();
+	rc_requests++;
+}
+
+/* call occasionally to perform any pending recomputation once things have been quiet for RC_QUIET,
+ * or with whatever is newest once RC_MAXWAIT has passed so a steady stream of changes, such as a
+ * jittery GPS location, can not hold it off forever.
+ */
+void Circum::checkRecompute()
+{
+	uint32_t m = millis();
+	if (!rc_pending || (m - rc_m0 < RC_QUIET && m - rc_first < RC_MAXWAIT))
+	    return;
+
+	resetWatchdog();
+
+	// claim the work first so any requests made while computing are not lost
+	uint8_t what = rc_pending;
+	rc_pending = 0;
+	rc_runs++;
+
+	if (what & RC_OBSERVER) {
+	    updateObserver (latitude, longitude, altitude);
+	    magdecl (latitude, longitude, altitude, decimalYear(), &magdeclination);
+	}
+
+	target->updateTopo();				// update target to new circumstances
+	if (what & RC_PASS) {
+	    target->findNextPass();			// update pass
+	    target->computeSkyPath();			// and show
+	}
+}
+
 /* call occasionally to sync our system time from GPS, if it is running ok.
+ * N.B. each call is limited to GPS_MAX_BYTES and GPS_MAX_US so a full buffer never holds up the gimbal,
+ *   the rest is left for the next call. Updating the Observer and magdecl for a new location is left
+ *   to checkRecompute().
  */
 void Circum::checkGPS()
 {
 	resetWatchdog();
+	uint32_t us0 = micros();
+
+	// keep the clock in step with PPS
+	checkPPS();
+
+	// update parse rate
+	uint32_t m = millis();
+	if (m - gps_bps_m0 >= 10000) {
+	    gps_bps = 1000*gps_bytes/(m - gps_bps_m0);
+	    gps_bytes = 0;
+	    gps_bps_m0 = m;
+	}
+
+	// note any bytes lost since last time
+#if defined(GPS_HWSERIAL)
+	if (ss->hasOverrun())
+	    gps_overruns++;
+#else
+	if (ss->overflow())
+	    gps_overruns++;
+#endif
+
+	// move bytes from GPS in chunks, process each new message as it completes
+	uint8_t buf[GPS_CHUNK];
+	for (uint16_t nread = 0; nread < GPS_MAX_BYTES && micros() - us0 < GPS_MAX_US; ) {
+	    size_t n = ss->available();
+	    if (n == 0)
+		break;
+	    n = ss->readBytes (buf, n < sizeof(buf) ? n : sizeof(buf));
+	    nread += n;
+	    gps_bytes += n;
+	    for (size_t i = 0; i < n; i++) {
+		if (GPS->encode(buf[i])) {
+		    uint32_t pus0 = micros();
+		    parseGPS();
+		    gps_parseus += ((int32_t)(micros() - pus0) - (int32_t)gps_parseus)/8;
+		}
+	    }
+	}
+
+	// parseGPS() only runs when a sentence completes, so a receiver that goes quiet, or
+	// only sends sentences without a fix, would hold the lock forever. age it here too.
+	if (gps_lock && m - gps_age_m0 >= GPS_AGE_MS) {
+	    gps_age_m0 = m;
+	    long lat, lng;
+	    unsigned long fix_date, fix_time, loc_fix_age, time_fix_age;
+	    GPS->get_position (&lat, &lng, &loc_fix_age);
+	    GPS->get_datetime (&fix_date, &fix_time, &time_fix_age);
+	    if (loc_fix_age > GPS_STALE || time_fix_age > GPS_STALE) {
+		DEBUG_SERIAL.println("Fix is stale, holding over");
+		gps_lock = false;
+	    }
+	}
 
-	// read more from GPS, process when new message complete
-	while (ss->available()) {
+	// record worst case
+	uint32_t dt = micros() - us0;
+	if (dt > gps_maxus)
+	    gps_maxus = dt;
+}
 
-	    // Serial.print((char)ss->peek());
+/* called by checkGPS() each time GPS completes a new sentence.
+ */
+void Circum::parseGPS()
+{
+	// note we receiving GPS sentences ok
+	gps_ok = true;
 
-	    if (GPS->encode(ss->read())) {
+	// get location and age as the parser's own integers, millionths of a degree and cm
+	long new_lat, new_lng, new_alt;
+	unsigned long loc_fix_age;
+	GPS->get_position(&new_lat, &new_lng, &loc_fix_age);
+	new_alt = GPS->altitude();
 
-		// note we receiving GPS sentences ok
-		gps_ok = true;
+	// get time and age, also integer
+	unsigned long time_fix_age;
+	int new_year; byte new_mon, new_day, new_hr, new_min, new_sec, new_hund;
+	GPS->crack_datetime (&new_year, &new_mon, &new_day, &new_hr, &new_min, &new_sec,
+			&new_hund, &time_fix_age);
 
-		// get location and age
-		float new_lat, new_lng, new_alt;
-		unsigned long loc_fix_age;
-		GPS->f_get_position(&new_lat, &new_lng, &loc_fix_age);
-		new_alt = GPS->f_altitude();
+	// determine whether data are up to date.
+	// N.B. TinyGPS keeps the last good fix, so without a current one its time would set us back
+	// N.B. GSA, GSV and ZDA complete too, so only say so when the lock is lost, as debug output
+	//   may share the GPS UART
+	if (loc_fix_age == GPSParser::GPS_INVALID_AGE || time_fix_age  == GPSParser::GPS_INVALID_AGE) {
+	    if (gps_lock)
+		DEBUG_SERIAL.println("No fix detected");
+	    gps_lock = false;
+	} else if (loc_fix_age > GPS_STALE || time_fix_age > GPS_STALE) {
+	    if (gps_lock)
+		DEBUG_SERIAL.println("Fix is stale, holding over");
+	    gps_lock = false;
+	} else {
+	    gps_lock = true;
+	}
 
-		// get time and age
-		unsigned long time_fix_age;
-		int new_year; byte new_mon, new_day, new_hr, new_min, new_sec, new_hund;
-		GPS->crack_datetime (&new_year, &new_mon, &new_day, &new_hr, &new_min, &new_sec,
-				&new_hund, &time_fix_age);
+	if (gps_lock) {
 
-		// determine whether data are up to date
-		if (loc_fix_age == TinyGPS::GPS_INVALID_AGE || time_fix_age  == TinyGPS::GPS_INVALID_AGE) {
-		    gps_lock = false;
-		    Serial.println("No fix detected");
+	    // update system time from GPS unless op has overridden
+	    if (!time_overridden) {
+		if (pps_lock) {
+		    // NMEA time labels the most recent pulse, which is also our epoch.
+		    // only resync if it disagrees, allowing for a sentence that was read
+		    // just after the following pulse.
+		    DateTime label (new_year, new_mon, new_day, 0, 0, 0);
+		    long sod = 3600L*new_hr + 60L*new_min + new_sec;
+		    long ds = 86400L*(dt_DN0 - label.DN) + (dt_S0 - sod);
+		    if (ds != 0 && ds != 1) {
+			setnow (new_year, new_mon, new_day, new_hr, new_min, new_sec, pps_prev);
+			time_src = TS_PPS;
+		    }
 		} else {
-		    gps_lock = true;
-		    if (loc_fix_age > 5000 || time_fix_age > 5000)
-			Serial.println("Warning: possible stale data!");
+		    // best we can do is assume the fix time is when the sentence arrived
+		    uint64_t us0 = micros64() - 1000ULL*time_fix_age - 10000ULL*new_hund;
+		    setnow (new_year, new_mon, new_day, new_hr, new_min, new_sec, us0);
+		    noteSync (dt_DN0, dt_S0, us0, NMEA_UNC);
+		    time_src = TS_GPS;
 		}
+	    }
 
-		if (gps_lock) {
+	    // update location from GPS, unless op has overridden or within allowed jitter.
+	    // N.B. compare in the parser's units so floats are only touched when we really move
+	    if (!loc_overridden 
+		    && (labs(gps_lat - new_lat) > GPS_JIT_ANGLE
+			|| labs(gps_lng - new_lng) > GPS_JIT_ANGLE
+			|| labs (gps_alt - new_alt) > GPS_JIT_ALT)
+		    ) {
 
-		    // update system time from GPS unless op has overridden
-		    if (!time_overridden)
-			setnow (new_year, new_mon, new_day, new_hr, new_min, new_sec);
+		gps_lat = new_lat;
+		gps_lng = new_lng;
+		gps_alt = new_alt;
+		latitude = 1e-6F*new_lat;
+		longitude = 1e-6F*new_lng;
+		altitude = 0.01F*new_alt;
 
-		    // update location from GPS, unless op has overridden or within allowed jitter
-		    if (!loc_overridden 
-			    && (fabs(latitude - new_lat) > 0.01
-				|| fabs(longitude - new_lng) > 0.01
-				|| fabs (altitude - new_alt) > 100)
-			    ) {
+		requestRecompute (RC_OBSERVER);
+	    }
 
-			latitude = new_lat;
-			longitude = new_lng;
-			altitude = new_alt;
+	    // get fix quality info
+	    unsigned long new_hdop = GPS->hdop();
+	    if (new_hdop != gps_hdop) {
+		gps_hdop = new_hdop;
+		hdop = 0.01F*new_hdop;
+	    }
+	    nsats = (int)GPS->satellites();
 
-			newObserver (latitude, longitude, altitude);
-			magdecl (latitude, longitude, altitude, decimalYear(), &magdeclination);
-		    }
+	}
+}
 
-		    // get fix quality info
-		    hdop = 0.01*GPS->hdop();
-		    nsats = (int)GPS->satellites();
+/* call often to get time from SNTP until GPS locks, and to refresh it occasionally while GPS is
+ * not locked so holdover uncertainty stays bounded. never blocks waiting for a reply.
+ */
+void Circum::checkNTP()
+{
+	if (ntp_waiting) {
+	    readNTP();
+	    return;
+	}
 
-		}
+	// nothing to do while GPS or op set the time, or not yet time to try again
+	if (gps_lock || time_overridden || millis() - ntp_m0 < ntp_interval)
+	    return;
+	if (WiFi.status() != WL_CONNECTED)
+	    return;
+
+	sendNTP();
+}
+
+/* send an SNTP request, resolving the server first if necessary.
+ * N.B. the lookup blocks, for at most NTP_DNS_MS, so it is only done when we have no address or
+ *   the one we have keeps failing, and failures back off.
+ */
+void Circum::sendNTP()
+{
+	resetWatchdog();
+	ntp_m0 = millis();
+
+	if (!ntp_resolved) {
+	    if (!WiFi.hostByName (NTP_SERVER, ntp_ip, NTP_DNS_MS)) {
+		DEBUG_SERIAL.println (F("NTP server not found"));
+		failNTP();
+		return;
 	    }
+	    ntp_resolved = true;
 	}
+	if (!ntp_ready) {
+	    ntp_udp.begin (NTP_LOCAL_PORT);
+	    ntp_ready = true;
+	}
+
+	// discard any stale reply
+	while (ntp_udp.parsePacket() > 0)
+	    ntp_udp.flush();
+
+	// LI 0, version 4, mode 3 client. our send time goes out as the transmit stamp and
+	// comes back as the origin stamp so we can tell the reply is to this request.
+	uint8_t pkt[NTP_PKTLEN];
+	memset (pkt, 0, sizeof(pkt));
+	pkt[0] = 0x23;
+	ntp_t1 = micros64();
+	for (uint8_t i = 0; i < 8; i++)
+	    pkt[40+i] = ntp_t1 >> (56 - 8*i);
+
+	ntp_udp.beginPacket (ntp_ip, NTP_PORT);
+	ntp_udp.write (pkt, sizeof(pkt));
+	if (ntp_udp.endPacket())
+	    ntp_waiting = true;
+	else
+	    failNTP();
 }
 
-/* get time from dt_now advanced to current millis()
+/* note a lookup or request that came to nothing: wait longer before the next, up to NTP_POLL,
+ * and look the server up again if requests keep going unanswered in case it moved.
+ */
+void Circum::failNTP()
+{
+	if (ntp_fails < 255)
+	    ntp_fails++;
+	ntp_interval = NTP_RETRY;
+	for (uint8_t i = 1; i < ntp_fails && ntp_interval < NTP_POLL; i++)
+	    ntp_interval *= 2;
+	if (ntp_interval > NTP_POLL)
+	    ntp_interval = NTP_POLL;
+	if (ntp_fails % NTP_REDNS == 0)
+	    ntp_resolved = false;
+}
+
+/* check for a reply to our SNTP request, set time from it if it is better than what we have.
+ */
+void Circum::readNTP()
+{
+	if (ntp_udp.parsePacket() < NTP_PKTLEN) {
+	    if (millis() - ntp_m0 > NTP_TIMEOUT) {
+		DEBUG_SERIAL.println (F("NTP timed out"));
+		ntp_waiting = false;
+		failNTP();
+	    }
+	    return;
+	}
+	uint64_t t4 = micros64();
+
+	uint8_t pkt[NTP_PKTLEN];
+	ntp_udp.read (pkt, sizeof(pkt));
+	ntp_udp.flush();
+
+	// must be a synchronized server replying to us
+	uint64_t stamp[3];			// origin, receive, transmit as 32.32 fixed point
+	for (uint8_t j = 0; j < 3; j++) {
+	    stamp[j] = 0;
+	    for (uint8_t i = 0; i < 8; i++)
+		stamp[j] = (stamp[j] << 8) | pkt[24+8*j+i];
+	}
+	uint8_t li = pkt[0] >> 6, mode = pkt[0] & 7, stratum = pkt[1];
+	if (stamp[0] != ntp_t1)
+	    return;				// not ours, keep waiting
+	ntp_waiting = false;
+	uint64_t held = stamp[2] - stamp[1];	// server turnaround
+	if (li == 3 || mode != 4 || stratum == 0 || stratum > 15 || (held >> 32) != 0) {
+	    DEBUG_SERIAL.println (F("NTP reply rejected"));
+	    failNTP();
+	    return;
+	}
+
+	// round trip less server turnaround, assume the reply took half of it
+	long held_us = (long)((held * 1000000ULL) >> 32);
+	long rtt_us = (long)(t4 - ntp_t1) - held_us;
+	if (rtt_us < 0)
+	    rtt_us = 0;
+	ntp_rtt = 1e-3F*rtt_us;
+	ntp_interval = NTP_POLL;
+	ntp_fails = 0;
+
+	// set time unless GPS locked while we waited, or we already know better
+	float unc = 1e-6F*rtt_us/2;
+	if (gps_lock || time_overridden || unc >= timeUncertainty())
+	    return;
+
+	// time at t4 is the transmit stamp plus the return trip, epoch is at the whole second before.
+	// N.B. NTP era 0 ends in 2036
+	uint32_t secs = stamp[2] >> 32;
+	long frac_us = (long)(((stamp[2] & 0xffffffffULL) * 1000000ULL) >> 32) + rtt_us/2;
+	secs += frac_us/1000000;
+	frac_us %= 1000000;
+	uint32_t unix_secs = secs - NTP_UNIX;
+	DateTime d1970 (1970, 1, 1, 0, 0, 0);
+	uint64_t us0 = t4 - frac_us;
+	setnow (d1970.DN + (long)(unix_secs/86400), (long)(unix_secs%86400), us0);
+	noteSync (dt_DN0, dt_S0, us0, unc);
+	time_src = TS_NTP;
+	requestRecompute (RC_PASS);
+
+	DEBUG_SERIAL.print (F("Time set from NTP, rtt ms: "));
+	DEBUG_SERIAL.println (ntp_rtt);
+}
+
+#if defined(GPS_UBX)
+
+/* configure the u-blox receiver to send just NAV-PVT at our fix rate.
+ * return whether all messages were acknowledged.
+ */
+bool Circum::configGPS()
+{
+	// CFG-RATE: measurement interval, one solution per measurement, aligned to UTC
+	const uint8_t rate[6] = {GPS_FIX_MS & 0xff, GPS_FIX_MS >> 8, 1, 0, 0, 0};
+	bool ok = sendUBX (UBX::CLS_CFG, UBX::ID_CFG_RATE, rate, sizeof(rate));
+
+	// CFG-MSG: class, id and rate on this port. turn on NAV-PVT, off the default NMEA sentences
+	static const uint8_t msgs[][3] = {
+	    {UBX::CLS_NAV, UBX::ID_NAV_PVT, 1},
+	    {UBX::CLS_NMEA, 0x00, 0},			// GGA
+	    {UBX::CLS_NMEA, 0x01, 0},			// GLL
+	    {UBX::CLS_NMEA, 0x02, 0},			// GSA
+	    {UBX::CLS_NMEA, 0x03, 0},			// GSV
+	    {UBX::CLS_NMEA, 0x04, 0},			// RMC
+	    {UBX::CLS_NMEA, 0x05, 0},			// VTG
+	};
+	for (uint8_t i = 0; i < sizeof(msgs)/sizeof(msgs[0]); i++)
+	    ok = sendUBX (UBX::CLS_CFG, UBX::ID_CFG_MSG, msgs[i], sizeof(msgs[i])) && ok;
+
+	DEBUG_SERIAL.println (ok ? F("GPS configured ok") : F("GPS did not acknowledge configuration"));
+	return (ok);
+}
+
+/* send the given UBX message, adding sync, length and checksum.
+ * return whether the receiver ACKs it within UBX_ACK_MS.
+ */
+bool Circum::sendUBX (uint8_t cls, uint8_t id, const uint8_t *body, uint16_t len)
+{
+	uint8_t buf[32];
+	uint8_t n = UBX::frame (cls, id, body, len, buf, sizeof(buf));
+	if (n == 0)
+	    return (false);
+	GPS->clearAck();
+	ss->write (buf, n);
+
+	// watch for its ACK or NAK
+	uint32_t t0 = millis();
+	while (GPS->acked (cls, id) < 0 && millis() - t0 < UBX_ACK_MS) {
+	    resetWatchdog();
+	    while (ss->available())
+		GPS->encode (ss->read());
+	}
+
+	return (GPS->acked (cls, id) == 1);
+}
+
+#else // !GPS_UBX
+
+/* configure the MTK receiver to send only the sentences we use at our fix rate.
+ * return whether all commands were acknowledged.
+ */
+bool Circum::configGPS()
+{
+	bool ok = sendPMTK (GPS_SENTENCES);
+
+	char cmd[20];
+	snprintf (cmd, sizeof(cmd), "PMTK220,%d", GPS_FIX_MS);
+	ok = sendPMTK (cmd) && ok;
+
+#if defined(GPS_FAST_BAUD)
+	// N.B. the receiver changes baud immediately so we never see the ack
+	snprintf (cmd, sizeof(cmd), "PMTK251,%ld", (long)GPS_FAST_BAUD);
+	sendPMTK (cmd);
+	ss->flush();
+#if defined(GPS_HWSERIAL)
+	ss->updateBaudRate(GPS_FAST_BAUD);
+#else
+	ss->begin(GPS_FAST_BAUD, GPS_RX_PIN, GPS_TX_PIN, SWSERIAL_8N1, GPS_INVERT, GPS_BUFSIZE);
+#endif
+#endif
+
+	DEBUG_SERIAL.println (ok ? F("GPS configured ok") : F("GPS did not acknowledge configuration"));
+	return (ok);
+}
+
+/* send the given PMTK command body, adding $, checksum and CRLF.
+ * return whether the receiver acknowledges it as valid and successful within PMTK_ACK_MS.
+ */
+bool Circum::sendPMTK (const char *body)
+{
+	// checksum is xor of all chars between $ and *
+	uint8_t cs = 0;
+	for (const char *bp = body; *bp; bp++)
+	    cs ^= *bp;
+	char tail[6];
+	snprintf (tail, sizeof(tail), "*%02X\r\n", cs);
+	ss->print ('$');
+	ss->print (body);
+	ss->print (tail);
+
+	// command number follows PMTK
+	pmtk_cmd = atoi (body+4);
+	pmtk_flag = -1;
+
+	// watch for its ack
+	uint32_t t0 = millis();
+	while (pmtk_flag < 0 && millis() - t0 < PMTK_ACK_MS) {
+	    resetWatchdog();
+	    while (ss->available())
+		checkPMTKAck (ss->read());
+	}
+
+	return (pmtk_flag == 3);		// 3 means valid command and action succeeded
+}
+
+/* collect $PMTK001,cmd,flag*cs sentences.
+ * when one completes with a good checksum and it is for pmtk_cmd, set pmtk_flag.
+ */
+void Circum::checkPMTKAck (char c)
+{
+	// start over at each $
+	if (c == '$') {
+	    pmtk_n = 0;
+	    pmtk_line[pmtk_n++] = c;
+	    return;
+	}
+	if (pmtk_n == 0)
+	    return;
+
+	// collect until end of line, abandon anything that is not PMTK or too long
+	if (c != '\r' && c != '\n') {
+	    if (pmtk_n >= sizeof(pmtk_line)-1 || (pmtk_n < 5 && c != "$PMTK"[pmtk_n]))
+		pmtk_n = 0;
+	    else
+		pmtk_line[pmtk_n++] = c;
+	    return;
+	}
+	pmtk_line[pmtk_n] = '\0';
+	pmtk_n = 0;
+
+	// confirm checksum
+	char *star = strchr (pmtk_line, '*');
+	if (!star)
+	    return;
+	uint8_t cs = 0;
+	for (char *lp = pmtk_line+1; lp < star; lp++)
+	    cs ^= *lp;
+	if (strtol (star+1, NULL, 16) != cs)
+	    return;
+
+	// crack
+	int cmd, flag;
+	if (sscanf (pmtk_line, "$PMTK001,%d,%d", &cmd, &flag) == 2 && cmd == pmtk_cmd)
+	    pmtk_flag = flag;
+}
+
+#endif // GPS_UBX
+
+/* process any new PPS pulses: estimate drift and jitter from the interval between pulses,
+ * record our clock offset then move the epoch up to the pulse.
+ */
+void Circum::checkPPS()
+{
+	// read a consistent pair from the ISR
+	uint32_t n, us;
+	do {
+	    n = pps_n;
+	    us = pps_us;
+	} while (n != pps_n);
+
+	// extend to 64 bits, fine as long as we look more often than every 71 minutes
+	uint64_t now64 = micros64();
+	uint64_t edge = now64 - (uint32_t)((uint32_t)now64 - us);
+
+	if (n == pps_seen) {
+	    // no new pulse, check for loss
+	    if (pps_lock && now64 - pps_prev > 1000ULL*PPS_TIMEOUT) {
+		DEBUG_SERIAL.println (F("PPS lost"));
+		pps_lock = false;
+	    }
+	    return;
+	}
+
+	// a good pulse is exactly one second after the previous one
+	bool good = n == pps_seen + 1 && pps_prev != 0;
+	float err = (int64_t)(edge - pps_prev) - 1000000LL;		// us
+	pps_seen = n;
+	pps_prev = edge;
+	if (!good || fabs(err) > PPS_MAXERR) {
+	    pps_lock = false;
+	    return;
+	}
+	if (!pps_lock)
+	    DEBUG_SERIAL.println (F("PPS locked"));
+	pps_lock = true;
+
+	// smooth drift and jitter
+	clk_drift += (1e-6F*err - clk_drift)/PPS_TAU;
+	clk_jitter += (fabs(err - 1e6F*clk_drift) - clk_jitter)/PPS_TAU;
+
+	// our time at the pulse in seconds since epoch should be whole.
+	// N.B. signed: NMEA may have set the epoch just after a pulse we had not yet processed,
+	//   that pulse says nothing about the new epoch so let the next one move it.
+	int64_t since = (int64_t)(edge - dt_us0);
+	if (since < 0)
+	    return;
+	double secs = since*1e-6/(1 + driftNow());
+	long whole = (long)floor(secs + 0.5);
+	clk_offset = (float)((secs - whole)*1e6);
+
+	// move epoch to this pulse, leaving any op setting alone.
+	// N.B. only a sync once NMEA has labeled the seconds
+	if (!time_overridden) {
+	    long s = dt_S0 + whole;
+	    long d = (long)floor(s/86400.0);
+	    dt_DN0 += d;
+	    dt_S0 = s - 86400L*d;
+	    dt_us0 = edge;
+	    if (gps_lock) {
+		noteSync (dt_DN0, dt_S0, edge, 1e-6F*fmax (clk_jitter, 1.0F));
+		time_src = TS_PPS;
+	    }
+	}
+}
+
+/* record that our epoch (DN, S) at micros64() us was just set from GPS or NTP with the given uncertainty.
+ * use the span since the first such sync as a baseline to learn the drift of our own clock.
+ * a new estimate replaces the one in use only if it is better, so a fresh baseline never undoes
+ * a good one from the last.
+ */
+void Circum::noteSync (long DN, long S, uint64_t us, float unc)
+{
+	sync_us = us;
+	sync_unc = unc;
+
+	// start a new baseline the first time and after a long time to follow aging
+	long true_secs = 86400L*(DN - ref_DN) + (S - ref_S);
+	if (!ever_synced || true_secs > DRIFT_BASE_MAX) {
+	    ever_synced = true;
+	    ref_us = us;
+	    ref_DN = DN;
+	    ref_S = S;
+	    ref_unc = unc;
+	    return;
+	}
+
+	// learn drift once the baseline is long enough that sync errors don't matter much.
+	// N.B. the estimate in use is compared with the allowance for its aging, as timeUncertainty() uses it
+	if (true_secs < DRIFT_BASE_MIN)
+	    return;
+	float sigma = (ref_unc + unc)/true_secs;
+	if (sigma >= DRIFT_UNKNOWN || (hold_learned && sigma >= hold_sigma + DRIFT_WANDER))
+	    return;
+	double local_secs = (double)(us - ref_us)*1e-6;
+	hold_drift = (float)(local_secs/true_secs - 1);
+	hold_sigma = sigma;
+	if (!hold_learned) {
+	    DEBUG_SERIAL.print (F("Clock drift learned, ppm: "));
+	    DEBUG_SERIAL.println (1e6*hold_drift, 2);
+	}
+	hold_learned = true;
+}
+
+/* return the best drift estimate for the local clock, local/true - 1
+ */
+float Circum::driftNow()
+{
+	if (pps_lock)
+	    return (clk_drift);
+	if (hold_learned)
+	    return (hold_drift);
+	return (0);
+}
+
+/* return whether we have lost GPS time sync and are running on our own clock.
+ * N.B. NTP time is only refreshed every NTP_POLL so running on our own clock between is normal.
+ */
+bool Circum::inHoldover()
+{
+	return ((time_src == TS_GPS || time_src == TS_PPS)
+			&& ever_synced && (micros64() - sync_us)*1e-6F > HOLD_START);
+}
+
+/* return estimated uncertainty of our time, secs.
+ * N.B. if the op has set the time, we can only assume they set it to within a second.
+ */
+float Circum::timeUncertainty()
+{
+	if (time_overridden)
+	    return (1.0F);
+	if (!ever_synced)
+	    return (1e9F);
+	float t = (micros64() - sync_us)*1e-6F;
+	if (t <= HOLD_START)
+	    return (sync_unc);
+	float rate = hold_learned ? hold_sigma + DRIFT_WANDER : DRIFT_UNKNOWN;
+	return (sync_unc + rate*t);
+}
+
+/* return whether our time is so uncertain that predictions should not be trusted.
+ * N.B. op override is their responsibility.
+ */
+bool Circum::timeSuspect()
+{
+	return (!time_overridden && timeUncertainty() > TIME_UNC_MAX);
+}
+
+/* advance dt_now to the current time
+ */
+void Circum::updateNow()
+{
+	double secs = dt_S0 + (double)(micros64() - dt_us0)*1e-6/(1 + driftNow());
+	long days = (long)floor(secs/86400.0);
+	dt_now.DN = dt_DN0 + days;
+	dt_now.TN = (float)((secs - 86400.0*days)/86400.0);
+	dt_Snow = (long)floor(secs - 86400.0*days);
+}
+
+/* get time from dt_now advanced to current micros64().
+ * the calendar breakdown is cached, it costs a full DateTime::gettime() only when the day changes
+ * and a few integer operations when the second changes.
  */
 void Circum::getnow(int &year, uint8_t &month, uint8_t &day, uint8_t &h, uint8_t &m, uint8_t &s)
 {
-	dt_now.TN = dt_TN0;
-	dt_now.DN = dt_DN0;
-	dt_now.add ((long)((millis() - dt_m0)/1000));
-	dt_now.gettime(year, month, day, h, m, s);
+	updateNow();
+
+	// new date
+	if (dt_now.DN != cal.DN) {
+	    DateTime d0;
+	    d0.DN = dt_now.DN;
+	    d0.TN = 0;
+	    d0.gettime (cal.year, cal.month, cal.day, h, m, s);
+	    DateTime y0 (cal.year, 1, 1, 0, 0, 0);
+	    cal.y0DN = y0.DN;
+	    cal.DN = dt_now.DN;
+	    cal.S = -1;
+	}
+
+	// new time, usually just the next second.
+	// N.B. h m s are only good to step from while S is, a new day invalidates them
+	if (dt_Snow != cal.S) {
+	    if (cal.S >= 0 && dt_Snow == cal.S + 1 && cal.s < 59) {
+		cal.s++;
+	    } else {
+		cal.h = dt_Snow/3600;
+		cal.m = (dt_Snow/60)%60;
+		cal.s = dt_Snow%60;
+	    }
+	    cal.S = dt_Snow;
+	}
+
+	year = cal.year;
+	month = cal.month;
+	day = cal.day;
+	h = cal.h;
+	m = cal.m;
+	s = cal.s;
+}
+
+/* set epoch to the given whole UTC second, which happened at micros64() us0
+ */
+void Circum::setnow(int year, uint8_t month, uint8_t day, uint8_t h, uint8_t m, uint8_t s, uint64_t us0)
+{
+	DateTime d0 (year, month, day, 0, 0, 0);
+	setnow (d0.DN, 3600L*h + 60L*m + s, us0);
+}
+
+/* set epoch to second S of day number DN, which happened at micros64() us0
+ */
+void Circum::setnow(long DN, long S, uint64_t us0)
+{
+	dt_DN0 = DN;
+	dt_S0 = S;
+	dt_us0 = us0;
+	updateNow();
 }
 
-/* init dt_now based on current millis()
+/* return the current time
  */
-void Circum::setnow(int year, uint8_t month, uint8_t day, uint8_t h, uint8_t m, uint8_t s)
+DateTime Circum::now()
 {
-	dt_m0 = millis();
-	dt_now.settime(year, month, day, h, m, s);
-	dt_TN0 = dt_now.TN;
-	dt_DN0 = dt_now.DN;
+	updateNow();
+	return (dt_now);
 }
 
 /* return age of satellite elements in days
@@ -352,18 +1200,18 @@ float Circum::age (Satellite *sat)
 
 }
 
-/* install a new Observer
+/* move the Observer to a new location.
+ * N.B. obs is updated in place so its address never changes and the heap is never touched.
  */
-void Circum::newObserver (float lat, float lng, float hgt)
+void Circum::updateObserver (float lat, float lng, float hgt)
 {
-	if (obs)
-	    delete (obs);
-	obs = new Observer (lat, lng, hgt);
+	obs.update (lat, lng, hgt);
 }
 
-/* return the current Observer
+/* return the current Observer.
+ * N.B. the pointer remains valid for the life of Circum even as the location changes.
  */
 Observer *Circum::observer()
 {
-	return (obs);
+	return (&obs);
 }
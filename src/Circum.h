@@ -1,14 +1,33 @@
 #ifndef _CIRCUM_H
 #define	_CIRCUM_H
 
+#include <ESP8266WiFi.h>
 #include <WiFiClient.h>
+#include <WiFiUdp.h>
 #include <SoftwareSerial.h>
+
+// define to run a u-blox receiver in UBX binary NAV-PVT mode instead of parsing NMEA
+// #define GPS_UBX
+
+#if defined(GPS_UBX)
+#include "UBX.h"
+typedef UBX GPSParser;
+#else
 #include <TinyGPS.h>
+typedef TinyGPS GPSParser;
+#endif
 
 #include "AutoSatTracker-ESP.h"
 #include "P13.h"
 #include "Target.h"
 
+// GPS_HWSERIAL is in AutoSatTracker-ESP.h so debug output can follow it
+#if defined(GPS_HWSERIAL)
+typedef HardwareSerial GPSSerial;
+#else
+typedef SoftwareSerial GPSSerial;
+#endif
+
 extern int magdecl ( double l, double L, double e, double y, double *mdp);
 
 class Circum {
@@ -22,24 +41,136 @@ class Circum {
 	bool time_overridden;		// some element of time has been set by op
 	bool loc_overridden;		// some element of location has been set by op
 
-	Observer *obs;			// topocentric place
-	SoftwareSerial *ss;		// GPS serial IO
+	Observer obs;			// topocentric place, updated in place
+	GPSSerial *ss;			// GPS serial IO
 
 	float decimalYear();
-	void newObserver (float lat, float lng, float hgt);
+	void updateObserver (float lat, float lng, float hgt);
 
-	/* implement on top of DateTime a running time based on elapsed millis()
+	/* implement on top of DateTime a running time based on elapsed micros64() since an epoch
+	 * that falls on a whole UTC second, disciplined by the GPS PPS pulse when it is connected.
 	 */
 	DateTime dt_now;
-	float dt_TN0;
-	long dt_DN0;
-	uint32_t dt_m0;
+	long dt_Snow;			// whole seconds into day of dt_now
+	long dt_DN0;			// day number at epoch
+	long dt_S0;			// whole seconds into day at epoch
+	uint64_t dt_us0;		// micros64() at epoch
+	float clk_drift;		// local clock rate error, local/true - 1
+	float clk_offset;		// our time - PPS time at most recent pulse, us
+	float clk_jitter;		// smoothed PPS interval deviation, us
+	bool pps_lock;			// set while PPS pulses keep arriving on time
+	uint32_t pps_seen;		// number of pulses already processed
+	uint64_t pps_prev;		// micros64() at most recent good pulse
+	void checkPPS();
+
+	/* holdover: learn the local clock drift while synced to GPS, then apply it and grow an
+	 * estimate of time uncertainty while not.
+	 */
+	bool ever_synced;		// whether we have ever synced to GPS or NTP since boot
+	uint64_t sync_us;		// micros64() at most recent sync
+	float sync_unc;			// time uncertainty at most recent sync, secs
+	uint64_t ref_us;		// micros64() at start of the drift learning baseline
+	long ref_DN, ref_S;		// UTC day number and seconds into day at ref_us
+	float ref_unc;			// time uncertainty at ref_us, secs
+	float hold_drift;		// drift learned over the baseline, local/true - 1
+	float hold_sigma;		// uncertainty of hold_drift
+	bool hold_learned;		// whether hold_drift is worth using
+	void noteSync (long DN, long S, uint64_t us, float unc);
+	float driftNow();
+
+	void updateNow();
+
+	/* calendar breakdown of dt_now, only redone when the second or day changes
+	 */
+	struct {
+	    long DN;			// day number of year .. day, -1 until first use
+	    long S;			// whole seconds into day of h .. s
+	    long y0DN;			// day number of Jan 1 of year
+	    int year;
+	    uint8_t month, day;
+	    uint8_t h, m, s;
+	} cal;
 	void getnow(int &year, uint8_t &month, uint8_t &day, uint8_t &h, uint8_t &m, uint8_t &s);
-	void setnow(int year, uint8_t month, uint8_t day, uint8_t h, uint8_t m, uint8_t s);
+	void setnow(int year, uint8_t month, uint8_t day, uint8_t h, uint8_t m, uint8_t s, uint64_t us0);
+	void setnow(long DN, long S, uint64_t us0);
+
+	/* where the current time came from
+	 */
+	typedef enum {
+	    TS_NONE,			// boot default
+	    TS_OP,			// entered by op
+	    TS_NTP,			// SNTP server
+	    TS_GPS,			// NMEA time alone
+	    TS_PPS,			// NMEA time disciplined by PPS
+	} TimeSource;
+	TimeSource time_src;
+
+	/* SNTP fallback until GPS locks
+	 */
+	WiFiUDP ntp_udp;		// SNTP socket, begun once WiFi is up
+	IPAddress ntp_ip;		// server address
+	bool ntp_resolved;		// set while ntp_ip is worth using
+	bool ntp_ready;			// set once ntp_udp is begun
+	bool ntp_waiting;		// set while a request is outstanding
+	uint8_t ntp_fails;		// consecutive lookups or requests that came to nothing
+	uint64_t ntp_t1;		// micros64() when request was sent, also its cookie
+	uint32_t ntp_m0;		// millis() when request was sent
+	uint32_t ntp_interval;		// ms after ntp_m0 before next request
+	float ntp_rtt;			// round trip of last good reply, ms, or < 0 if none yet
+	void sendNTP();
+	void readNTP();
+	void failNTP();
+
+	/* changes are collected and recomputed together once they stop arriving
+	 */
+	static const uint16_t RC_QUIET = 300;	// ms without new requests before recomputing
+	static const uint16_t RC_MAXWAIT = 3000;	// ms to wait for quiet before recomputing anyway
+	uint8_t rc_pending;		// RC_* work waiting to be done
+	uint32_t rc_m0;			// millis() of most recent request
+	uint32_t rc_first;		// millis() of first request still pending
+	uint16_t rc_requests;		// number of requests
+	uint16_t rc_runs;		// number of recomputations actually performed
+
+	uint32_t gps_maxus;		// longest checkGPS() so far, us
+	uint32_t gps_bytes;		// bytes parsed since gps_bps_m0
+	uint32_t gps_bps;		// recent bytes parsed per second
+	uint32_t gps_bps_m0;		// millis() when gps_bytes was reset
+	uint32_t gps_overruns;		// times the receive buffer has overflowed
+	uint32_t gps_parseus;		// smoothed time to handle one sentence, us
+	uint32_t gps_age_m0;		// millis() the fix was last aged without a new sentence
+	long gps_lat, gps_lng;		// location last used, millionths of a degree
+	long gps_alt;			// altitude last used, cm
+	unsigned long gps_hdop;		// hdop last used, 100ths
+	void parseGPS();
+#if !defined(_GPS_NO_EXTENDED)
+	void sendExtendedValues (WiFiClient client);
+#endif
+
+	/* receiver configuration
+	 */
+	bool gps_configured;		// whether receiver acked our configuration
+	bool configGPS();
+#if defined(GPS_UBX)
+	bool sendUBX (uint8_t cls, uint8_t id, const uint8_t *body, uint16_t len);
+#else
+	int pmtk_cmd;			// PMTK command number awaiting ack
+	int pmtk_flag;			// its ack flag, -1 until received
+	char pmtk_line[24];		// PMTK sentence being collected
+	uint8_t pmtk_n;			// chars in pmtk_line, 0 when not collecting
+	bool sendPMTK (const char *body);
+	void checkPMTKAck (char c);
+#endif
 
     public:
 
-	TinyGPS *GPS;			// GPS parser
+	typedef enum {
+	    RC_OBSERVER = 1,		// location changed: move Observer, new magdecl
+	    RC_PASS = 2,		// time, location or elements changed: new pass and sky path
+	} Recompute;
+	void requestRecompute (uint8_t what);
+	void checkRecompute();
+
+	GPSParser *GPS;			// GPS parser
 	double magdeclination;		// true az - magnetic az
 	float latitude, longitude;	// degs +N, +E
 	float altitude;			// altitude above MSL, m
@@ -50,7 +181,11 @@ class Circum {
 	void sendNewValues (WiFiClient client);
 	bool overrideValue (char *name, char *value);
 	void checkGPS();
-	DateTime now() {return dt_now;};
+	void checkNTP();
+	DateTime now();
+	float timeUncertainty();
+	bool inHoldover();
+	bool timeSuspect();
 	float age (Satellite *sat);
 	Observer *observer();
 	void printSexa (WiFiClient client, float v);
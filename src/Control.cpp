@@ -0,0 +1,162 @@
+/* this class runs the tracking loop as separate sense, estimate and actuate steps, each at its
+ * own rate, and measures how late each one runs.
+ */
+
+#include "Control.h"
+#include "NV.h"
+#include "Sensor.h"
+#include "Gimbal.h"
+#include "Target.h"
+#include "Webpage.h"
+
+/* constructor
+ */
+Control::Control()
+{
+	// periods from EEPROM if set, else defaults
+	nv->get();
+	bool nv_ok = nv->ctrl_ok == NV::VALID;
+	step[SENSE].period = nv_ok ? nv->ctrl_ms[SENSE] : SENSE_MS;
+	step[ESTIMATE].period = nv_ok ? nv->ctrl_ms[ESTIMATE] : ESTIMATE_MS;
+	step[ACTUATE].period = nv_ok ? nv->ctrl_ms[ACTUATE] : ACTUATE_MS;
+
+	// all due now
+	uint32_t now = micros();
+	for (uint8_t i = 0; i < NSTEPS; i++) {
+	    StepInfo *sp = &step[i];
+	    sp->due = now;
+	    sp->late_us = 0;
+	    sp->late_max = 0;
+	    sp->skipped = 0;
+	    sp->report_late = 0;
+	    sp->report_skipped = 0;
+	}
+	window_us = now;
+}
+
+/* call from loop() as often as possible to run each step when it is due
+ */
+void Control::run()
+{
+	uint32_t now = micros();
+
+	if (isDue (SENSE, now))
+	    sensor->update();
+	if (isDue (ESTIMATE, now))
+	    gimbal->estimate();
+	if (isDue (ACTUATE, now)) {
+	    target->track();
+	    gimbal->stepProfile();
+	}
+
+	// close the reporting window so each page polling us sees the same counts
+	if (now - window_us >= 1000UL*REPORT_MS) {
+	    for (uint8_t i = 0; i < NSTEPS; i++) {
+		StepInfo *sp = &step[i];
+		sp->report_late = sp->late_max;
+		sp->report_skipped = sp->skipped;
+		sp->late_max = 0;
+		sp->skipped = 0;
+	    }
+	    window_us = now;
+	}
+}
+
+/* return whether step s is due to run at micros() now, and if so schedule its next run.
+ * runs are kept in phase so lateness does not accumulate, but if a whole period has been
+ * missed we start afresh rather than run several times to catch up.
+ */
+bool Control::isDue (Step s, uint32_t now)
+{
+	StepInfo *sp = &step[s];
+	int32_t late = (int32_t)(now - sp->due);
+	if (late < 0)
+	    return (false);
+
+	sp->late_us += LATE_ALPHA*(late - sp->late_us);
+	if ((uint32_t)late > sp->late_max)
+	    sp->late_max = late;
+
+	sp->due += 1000UL*sp->period;
+	if ((int32_t)(now - sp->due) >= 0) {
+	    sp->due = now + 1000UL*sp->period;
+	    sp->skipped++;
+	}
+
+	return (true);
+}
+
+/* set a new period for step s, in ms, and save all periods in EEPROM
+ */
+void Control::setPeriod (Step s, uint16_t ms)
+{
+	step[s].period = ms;
+	step[s].due = micros();
+
+	for (uint8_t i = 0; i < NSTEPS; i++)
+	    nv->ctrl_ms[i] = step[i].period;
+	nv->ctrl_ok = NV::VALID;
+	nv->put();
+}
+
+/* process name = value.
+ * return whether we recognize it
+ */
+bool Control::overrideValue (char *name, char *value)
+{
+	Step s;
+	if (!strcmp (name, "C_SenseMs"))
+	    s = SENSE;
+	else if (!strcmp (name, "C_EstMs"))
+	    s = ESTIMATE;
+	else if (!strcmp (name, "C_ActMs"))
+	    s = ACTUATE;
+	else
+	    return (false);
+
+	int ms = atoi (value);
+	if (ms < MIN_MS || ms > MAX_MS) {
+	    webpage->setUserMessage (F("Control period must be 10 .. 2000 ms!"));
+	} else {
+	    setPeriod (s, ms);
+	    webpage->setUserMessage (F("Control period saved in EEPROM+"));
+	}
+	return (true);
+}
+
+/* send the period and lateness of step s.
+ * lateness is shown as mean/max ms, the max over the last reporting window, marked if it ever
+ * took a whole period.
+ */
+void Control::sendStep (WiFiClient client, Step s, const __FlashStringHelper *period_name,
+const __FlashStringHelper *late_name)
+{
+	StepInfo *sp = &step[s];
+
+	client.print (period_name); client.print (F("="));
+	    client.println (sp->period);
+
+	client.print (late_name); client.print (F("="));
+	    client.print (sp->late_us/1000, 1); client.print (F("/"));
+	    client.print (sp->report_late/1000.0F, 1);
+	    client.println (sp->report_late >= 1000UL*sp->period ? F("!") : F(""));
+}
+
+/* send latest web values, status counts runs skipped in the last reporting window.
+ * N.B. must match id's in main web page
+ */
+void Control::sendNewValues (WiFiClient client)
+{
+	client.print (F("C_Status="));
+	uint32_t skipped = 0;
+	for (uint8_t i = 0; i < NSTEPS; i++)
+	    skipped += step[i].report_skipped;
+	if (skipped > 0) {
+	    client.print (skipped); client.println (F(" late!"));
+	} else
+	    client.println (F("Ok+"));
+
+	sendStep (client, SENSE, F("C_SenseMs"), F("C_SenseLate"));
+	sendStep (client, ESTIMATE, F("C_EstMs"), F("C_EstLate"));
+	sendStep (client, ACTUATE, F("C_ActMs"), F("C_ActLate"));
+}
@@ -0,0 +1,62 @@
+/* this class runs the tracking loop as separate sense, estimate and actuate steps, each at its
+ * own rate, and measures how late each one runs.
+ */
+
+#ifndef _CONTROL_H
+#define _CONTROL_H
+
+#include <WiFiClient.h>
+
+#include "AutoSatTracker-ESP.h"
+
+class Control {
+
+    public:
+
+	// the steps, in the order they run when due together
+	typedef enum {
+	    SENSE,			// read the spatial sensor
+	    ESTIMATE,			// fold new readings into the pointing estimate
+	    ACTUATE,			// command the gimbal towards the target and ramp the motors
+	    NSTEPS
+	} Step;
+
+	Control();
+	void run();
+	uint16_t period (Step s) { return (step[s].period); }
+	void sendNewValues (WiFiClient client);
+	bool overrideValue (char *name, char *value);
+
+    private:
+
+	enum {
+	    SENSE_MS = 50,		// default ms between sensor reads
+	    ESTIMATE_MS = 50,		// default ms between estimates
+	    ACTUATE_MS = 100,		// default ms between gimbal updates
+	    MIN_MS = 10,		// shortest period allowed, the sensor fuses at 100 Hz
+	    MAX_MS = 2000,		// longest period allowed
+	    REPORT_MS = 10000,		// reporting window, the same for every page showing it
+	};
+	static constexpr float LATE_ALPHA = 0.05;	// weight of each new lateness in late_us
+
+	typedef struct {
+	    uint16_t period;		// ms between runs
+	    uint32_t due;		// micros() when next to run
+	    float late_us;		// smoothed lateness, us
+	    uint32_t late_max;		// worst lateness in this reporting window, us
+	    uint32_t skipped;		// periods missed entirely in this reporting window
+	    uint32_t report_late;	// late_max of the last whole window, us
+	    uint32_t report_skipped;	// skipped in the last whole window
+	} StepInfo;
+	StepInfo step[NSTEPS];
+	uint32_t window_us;		// micros() this reporting window began
+
+	bool isDue (Step s, uint32_t now);
+	void setPeriod (Step s, uint16_t ms);
+	void sendStep (WiFiClient client, Step s, const __FlashStringHelper *period_name,
+		const __FlashStringHelper *late_name);
+};
+
+extern Control *control;
+
+#endif // _CONTROL_H
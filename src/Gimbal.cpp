@@ -3,7 +3,9 @@
 
 #include "Gimbal.h"
 
-/* issue raw motor command in microseconds pulse width, clamped at limit
+/* command a new motor position in microseconds pulse width, clamped at limit.
+ * the pulse ramps there in stepProfile(), except the first which we send at once since we
+ * can not know where the servo starts.
  */
 void Gimbal::setMotorPosition (uint8_t motn, uint16_t newpos)
 {
@@ -20,8 +22,58 @@ void Gimbal::setMotorPosition (uint8_t motn, uint16_t newpos)
 
 	mip->del_pos = (int)newpos - (int)mip->pos;
 	mip->pos = newpos;
-	pwm->setPWM(mip->servo_num, 0, mip->pos/US_PER_BIT);
-	// Serial.print(mip->servo_num); Serial.print(" "); Serial.println (newpos);
+	if (mip->del_pos != 0) {
+	    moving = true;
+	    cmd_ms = move_ms = millis();
+	    filterPredict (motn);
+	}
+	if (mip->out == 0) {
+	    mip->out = mip->pos;
+	    pwm->setPWM(mip->servo_num, 0, mip->pos/US_PER_BIT);
+	}
+	// DEBUG_SERIAL.print(mip->servo_num); DEBUG_SERIAL.print(" "); DEBUG_SERIAL.println (newpos);
+}
+
+/* move each motor output one step closer to its commanded position, Control calls this at the
+ * actuation rate. speed ramps up and down within max_acc and is capped at max_vel, so the
+ * antenna and sensor are not jolted.
+ */
+void Gimbal::stepProfile()
+{
+	if (!gimbal_found)
+	    return;
+
+	uint32_t now = millis();
+	float dt = fminf ((now - profile_ms)/1000.0F, 0.5F);
+	profile_ms = now;
+
+	for (uint8_t i = 0; i < NMOTORS; i++) {
+	    MotorInfo *mip = &motor[i];
+	    if (mip->out == 0 || (mip->out == mip->pos && mip->vel == 0))
+		continue;
+
+	    // fastest we can go and still stop at pos, allowing for slowing only once per step
+	    float d = mip->pos - mip->out;
+	    float h = max_acc*dt/2;
+	    float v_want = fminf (sqrtf (h*h + 2.0F*max_acc*fabsf(d)) - h, max_vel);
+	    if (d < 0)
+		v_want = -v_want;
+
+	    // change speed towards that no faster than max_acc allows
+	    float dv = v_want - mip->vel;
+	    float dv_max = max_acc*dt;
+	    mip->vel += fmaxf (fminf (dv, dv_max), -dv_max);
+	    mip->out += mip->vel*dt;
+
+	    // done when we get there or would go past
+	    if (fabsf(d) < 1 || (d > 0 && mip->out >= mip->pos) || (d < 0 && mip->out <= mip->pos)) {
+		mip->out = mip->pos;
+		mip->vel = 0;
+	    }
+
+	    pwm->setPWM(mip->servo_num, 0, mip->out/US_PER_BIT);
+	    move_ms = now;
+	}
 }
 
 /* constructor 
@@ -33,10 +85,10 @@ Gimbal::Gimbal ()
 	Wire.beginTransmission(GIMBAL_I2C_ADDR);
 	gimbal_found = (Wire.endTransmission() == 0);
 	if (!gimbal_found) {
-	    Serial.println (F("PWM controller not found"));
+	    DEBUG_SERIAL.println (F("PWM controller not found"));
 	    return;
 	}
-	Serial.println (F("PWM controller found ok"));
+	DEBUG_SERIAL.println (F("PWM controller found ok"));
 
 	// instantiate PWM controller
 	pwm = new Adafruit_PWMServoDriver(&Wire,GIMBAL_I2C_ADDR);
@@ -52,6 +104,7 @@ Gimbal::Gimbal ()
 	motor[0].min = nv->mot0min;
 	motor[0].max = nv->mot0max;
 	motor[0].pos = 0;
+	motor[0].out = motor[0].vel = 0;
 	motor[0].atmin = false;
 	motor[0].atmax = false;
 	motor[0].az_scale = 0;
@@ -60,6 +113,7 @@ Gimbal::Gimbal ()
 	motor[1].min = nv->mot1min;
 	motor[1].max = nv->mot1max;
 	motor[1].pos = 0;
+	motor[1].out = motor[1].vel = 0;
 	motor[1].atmin = false;
 	motor[1].atmax = false;
 	motor[1].az_scale = 0;
@@ -68,51 +122,133 @@ Gimbal::Gimbal ()
 	// init to arbitrary, but at least defined, state
 	init_step = 0;
 	best_azmotor = 0;
-	last_update = 0;
-	prevfast_az = prevfast_el = -1000;
+	moving = false;
+	cmd_ms = move_ms = 0;
+	max_vel = nv->prof_ok == NV::VALID ? nv->prof_vel : MAX_VEL;
+	max_acc = nv->prof_ok == NV::VALID ? nv->prof_acc : MAX_ACC;
+	profile_ms = millis();
+	settle_ms = 0;
 	prevstop_az = prevstop_el = -1000;
+	kf_ok = false;
+	kf_ms = 0;
+	lat_ms = lead_ms = 0;
+	err_sq = 0;
+	err_ok = false;
+
+	// saved scales need only be checked
+	warm = nv->scale_ok == NV::VALID;
+	for (uint8_t i = 0; warm && i < NMOTORS; i++) {
+	    motor[i].az_scale = nv->mot_scale[i][0];
+	    motor[i].el_scale = nv->mot_scale[i][1];
+	    if (isnan (motor[i].az_scale) || isnan (motor[i].el_scale)
+			|| motor[i].az_scale == 0 || motor[i].el_scale == 0)
+		warm = false;
+	}
+	if (warm)
+	    best_azmotor = nv->best_azmotor ? 1 : 0;
+	verify_az = verify_el = 0;
+	scale_dirty = false;
+	scale_save_ms = millis();
+	npath = 0;
+	plan_pending = plan_ok = plan_up = plan_flip = false;
+	plan_fits = 0;
+	plan_ma = ref_ma = ref_me = 0;
+	ref_pa = ref_pe = 0;
+	flipped = false;
 }
 
-/* move motors towards the given new target az and el 
+/* fold any new sensor sample into the pointing estimate, Control calls this at the estimation rate.
  */
-void Gimbal::moveToAzEl (float az_t, float el_t)
+void Gimbal::estimate()
 {
-	// only update every UPD_PERIOD
-	uint32_t now = millis();
-	if (now - last_update < UPD_PERIOD)
+	if (!gimbal_found || !sensor->connected())
 	    return;
-	last_update = now;
-
-	// read current sensor direction
-	float az_s, el_s;
-	sensor->getAzEl (&az_s, &el_s);
 
-	// only check further when motion has stopped as evidenced by stable sensor values
-	if (fabs (azDist (prevfast_az, az_s)) < MAX_SETTLE && fabs (el_s - prevfast_el) < MAX_SETTLE) {
-
-	    // calibrate if not already else seek target
-	    if (!calibrated())
+	float az_m, el_m;
+	uint32_t ms = millis() - sensor->getAzEl (&az_m, &el_m);
+	if (!kf_ok || ms != kf_ms)
+	    filterUpdate (az_m, el_m, ms);
+}
 
-		calibrate (az_s, el_s);
+/* move motors towards the given new target az and el, which are changing at the given rates,
+ * degs/sec, and accelerations, degs/sec^2.
+ */
+void Gimbal::moveToAzEl (float az_t, float el_t, float az_rate, float el_rate, float az_acc, float el_acc)
+{
+	// track how far off the target we are
+	if (calibrated() && kf_ok) {
+	    float az_err = azDist (kf_az.x, az_t)*cosf (radians (el_t));
+	    float el_err = el_t - kf_el.x;
+	    float e2 = az_err*az_err + el_err*el_err;
+	    err_sq = err_ok ? err_sq + ERR_ALPHA*(e2 - err_sq) : e2;
+	    err_ok = true;
+	}
 
-	    else
+	// a planned pass is done once it has set, whether or not we are still moving
+	if (plan_ok) {
+	    if (el_t >= 0)
+		plan_up = true;
+	    else if (plan_up)
+		plan_ok = false;
+	}
 
-		seekTarget (az_t, el_t, az_s, el_s);
-	    
+	// only check further when motion has stopped as evidenced by little spread in the
+	// sensor values since the last move. az spread shrinks towards the zenith.
+	Sensor::Window w;
+	if (!sensor->getWindow (w, move_ms) || w.n < SETTLE_N)
+	    return;
+	float cosel = cosf (radians (w.el_med));
+	if (w.az_var*cosel*cosel > MAX_SETTLE_VAR || w.el_var > MAX_SETTLE_VAR)
+	    return;
+	if (moving) {
+	    settle_ms = millis() - cmd_ms;
+	    moving = false;
+
+	    // a move commanded now is reached one servo delay later, then held until the next
+	    // one is reached a whole settle and actuate cycle after that, so aim for the middle
+	    // of the hold. the servo delay is the settle time less the samples to detect it.
+	    lat_ms = lat_ms == 0 ? settle_ms : lat_ms + LAT_ALPHA*(settle_ms - lat_ms);
+	    float servo_ms = fmaxf (lat_ms - SETTLE_N*control->period(Control::SENSE), 0);
+	    lead_ms = servo_ms + (lat_ms + control->period(Control::ACTUATE))/2;
+	}
 
-	    // preserve for next stopped iteration
-	    prevstop_az = az_s;
-	    prevstop_el = el_s;
+	// use median as the stopped position, robust to an odd bad sample
+	float az_s = w.az_med;
+	float el_s = w.el_med;
+
+	// calibrate if not already else seek where the target will be when the move takes effect
+	if (!calibrated())
+	    calibrate (az_s, el_s);
+	else {
+	    // wait where a planned pass will rise
+	    if (plan_ok && !plan_up) {
+		az_t = path[0].az;
+		el_t = fmaxf (path[0].el, 0);
+		az_rate = el_rate = az_acc = el_acc = 0;
+	    }
 
+	    float az_l = myfmod (az_t + leadAngle (az_rate, az_acc, lead_ms) + 360, 360);
+	    float el_l = el_t + leadAngle (el_rate, el_acc, lead_ms);
+	    seekTarget (az_l, el_l, az_s, el_s);
 	}
 
-	// preserve for next fast iteration
-	prevfast_az = az_s;
-	prevfast_el = el_s;
+	// preserve for next stopped iteration
+	prevstop_az = az_s;
+	prevstop_el = el_s;
+}
+
+/* return how far a target moving at rate with acceleration acc goes in lead_ms, within MAX_LEAD
+ */
+float Gimbal::leadAngle (float rate, float acc, float lead_ms)
+{
+	float dt = lead_ms/1000;
+	float d = rate*dt + acc*dt*dt/2;
+	return (fmaxf (fminf (d, MAX_LEAD), -MAX_LEAD));
 }
 
 /* run the next step of the initial scale calibration series.
- * steps proceed using init_step up to N_INIT_STEPS
+ * steps proceed using init_step up to N_INIT_STEPS.
+ * with scales saved from a previous boot, step 1 moves both motors a little and step 3 checks it.
  */
 void Gimbal::calibrate (float& az_s, float& el_s)
 {
@@ -131,12 +267,24 @@ void Gimbal::calibrate (float& az_s, float& el_s)
 
 	case 1:
 
+	    // with saved scales just move both motors a little and check the result in step 3
+	    if (warm) {
+		int16_t d0 = VERIFY_FRAC*range0;
+		int16_t d1 = VERIFY_FRAC*range1;
+		verify_az = d0/motor[0].az_scale + d1/motor[1].az_scale;
+		verify_el = d0/motor[0].el_scale + d1/motor[1].el_scale;
+		setMotorPosition (0, motor[0].pos + d0);
+		setMotorPosition (1, motor[1].pos + d1);
+		init_step = 3;
+		break;
+	    }
+
 	    // move just motor 0 a subtantial distance
 	    /*
-	    Serial.print(F("Init 1: Mot 0 starts at:\t"));
-		Serial.print(az_s); Serial.print(F("\t"));
-		Serial.print (el_s); Serial.print(F("\tMoves\t"));
-		Serial.println(CAL_FRAC*range0, 0);
+	    DEBUG_SERIAL.print(F("Init 1: Mot 0 starts at:\t"));
+		DEBUG_SERIAL.print(az_s); DEBUG_SERIAL.print(F("\t"));
+		DEBUG_SERIAL.print (el_s); DEBUG_SERIAL.print(F("\tMoves\t"));
+		DEBUG_SERIAL.println(CAL_FRAC*range0, 0);
 	    */
 	    setMotorPosition (0, motor[0].pos + CAL_FRAC*range0);
 	    break;
@@ -147,46 +295,66 @@ void Gimbal::calibrate (float& az_s, float& el_s)
 	    motor[0].az_scale = CAL_FRAC*range0/azDist(prevstop_az, az_s);
 	    motor[0].el_scale = CAL_FRAC*range0/(el_s - prevstop_el);
 	    /*
-	    Serial.print(F("Init 2: Mot 0 ended  at:\t"));
-		Serial.print(az_s); Serial.print(F("\t"));
-		Serial.print (el_s); Serial.print(F("\tusec:\t"));
-		Serial.print (CAL_FRAC*range0); Serial.print (F("\tDel usec/Deg:\t"));
-		Serial.print (motor[0].az_scale); Serial.print (F("\t"));
-		Serial.println (motor[0].el_scale);
+	    DEBUG_SERIAL.print(F("Init 2: Mot 0 ended  at:\t"));
+		DEBUG_SERIAL.print(az_s); DEBUG_SERIAL.print(F("\t"));
+		DEBUG_SERIAL.print (el_s); DEBUG_SERIAL.print(F("\tusec:\t"));
+		DEBUG_SERIAL.print (CAL_FRAC*range0); DEBUG_SERIAL.print (F("\tDel usec/Deg:\t"));
+		DEBUG_SERIAL.print (motor[0].az_scale); DEBUG_SERIAL.print (F("\t"));
+		DEBUG_SERIAL.println (motor[0].el_scale);
 	    */
 
 	    // repeat procedure for motor 1
 	    /*
-	    Serial.print(F("Init 2: Mot 1 starts at:\t"));
-		Serial.print(az_s); Serial.print(F("\t"));
-		Serial.print (el_s); Serial.print(F("\tMoves\t"));
-		Serial.println(CAL_FRAC*range1, 0);
+	    DEBUG_SERIAL.print(F("Init 2: Mot 1 starts at:\t"));
+		DEBUG_SERIAL.print(az_s); DEBUG_SERIAL.print(F("\t"));
+		DEBUG_SERIAL.print (el_s); DEBUG_SERIAL.print(F("\tMoves\t"));
+		DEBUG_SERIAL.println(CAL_FRAC*range1, 0);
 	    */
 	    setMotorPosition (1, motor[1].pos + CAL_FRAC*range1);
 	    break;
 
 	case 3:
 
+	    // saved scales are good if they predicted the check move, else calibrate afresh
+	    if (warm) {
+		float az_bad = fabsf (azDist (prevstop_az, az_s) - verify_az)*cosf (radians (el_s));
+		float el_bad = fabsf (el_s - prevstop_el - verify_el);
+		if (az_bad > fmaxf (VERIFY_TOL, VERIFY_REL*fabsf (verify_az))
+			    || el_bad > fmaxf (VERIFY_TOL, VERIFY_REL*fabsf (verify_el))) {
+		    DEBUG_SERIAL.print (F("Saved scales off by\t"));
+			DEBUG_SERIAL.print (az_bad); DEBUG_SERIAL.print (F("\t"));
+			DEBUG_SERIAL.println (el_bad);
+		    webpage->setUserMessage (F("Saved servo scales failed check, recalibrating!"));
+		    warm = false;
+		    init_step = 0;
+		    break;
+		}
+		DEBUG_SERIAL.println (F("Saved scales verified"));
+		target->setTrackingState (true);
+		break;
+	    }
+
 	    // calculate scale of motor 1
 	    motor[1].az_scale = CAL_FRAC*range1/azDist(prevstop_az, az_s);
 	    motor[1].el_scale = CAL_FRAC*range1/(el_s - prevstop_el);
 	    /*
-	    Serial.print(F("Init 3: Mot 1 ended  at:\t"));
-		Serial.print(az_s); Serial.print(F("\t"));
-		Serial.print (el_s); Serial.print(F("\tusec:\t"));
-		Serial.print (CAL_FRAC*range1); Serial.print (F("\tDel usec/Deg:\t"));
-		Serial.print (motor[1].az_scale); Serial.print (F("\t"));
-		Serial.println (motor[1].el_scale);
+	    DEBUG_SERIAL.print(F("Init 3: Mot 1 ended  at:\t"));
+		DEBUG_SERIAL.print(az_s); DEBUG_SERIAL.print(F("\t"));
+		DEBUG_SERIAL.print (el_s); DEBUG_SERIAL.print(F("\tusec:\t"));
+		DEBUG_SERIAL.print (CAL_FRAC*range1); DEBUG_SERIAL.print (F("\tDel usec/Deg:\t"));
+		DEBUG_SERIAL.print (motor[1].az_scale); DEBUG_SERIAL.print (F("\t"));
+		DEBUG_SERIAL.println (motor[1].el_scale);
 	    */
 
 	    // select best motor for az
 	    best_azmotor = fabs(motor[0].az_scale) < fabs(motor[1].az_scale) ? 0 : 1;
-	    Serial.print (F("Best Az motor:\t"));
-		Serial.print (best_azmotor); Serial.print (F("\tScale:\t"));
-		Serial.print (motor[best_azmotor].az_scale);
-		Serial.print (F("\tEl motor:\t"));
-		Serial.print (!best_azmotor); Serial.print (F("\tScale:\t"));
-		Serial.println (motor[!best_azmotor].el_scale);
+	    DEBUG_SERIAL.print (F("Best Az motor:\t"));
+		DEBUG_SERIAL.print (best_azmotor); DEBUG_SERIAL.print (F("\tScale:\t"));
+		DEBUG_SERIAL.print (motor[best_azmotor].az_scale);
+		DEBUG_SERIAL.print (F("\tEl motor:\t"));
+		DEBUG_SERIAL.print (!best_azmotor); DEBUG_SERIAL.print (F("\tScale:\t"));
+		DEBUG_SERIAL.println (motor[!best_azmotor].el_scale);
+	    saveScales();
 
 	    // report we have finished calibrating
 	    target->setTrackingState (true);
@@ -199,29 +367,49 @@ void Gimbal::calibrate (float& az_s, float& el_s)
 	}
 }
 
-/* run the next step of seeking the given target given the current stable az/el sensor values
+/* save the motor scales in EEPROM so the next boot need only check them
+ */
+void Gimbal::saveScales()
+{
+	for (uint8_t i = 0; i < NMOTORS; i++) {
+	    nv->mot_scale[i][0] = motor[i].az_scale;
+	    nv->mot_scale[i][1] = motor[i].el_scale;
+	}
+	nv->best_azmotor = best_azmotor;
+	nv->scale_ok = NV::VALID;
+	nv->put();
+	scale_dirty = false;
+	scale_save_ms = millis();
+}
+
+/* run the next step of seeking the given target given the current stable az/el sensor values.
+ * the error is taken from the filtered estimate, the scales are refined from the sensor alone.
  */
 void Gimbal::seekTarget (float& az_t, float& el_t, float& az_s, float& el_s)
 {
-	// find pointing error in each dimension as a move from sensor to target
-	float az_err = azDist (az_s, az_t);
-	float el_err = el_t - el_s;
+	// plan a new pass from where we are now
+	if (plan_pending)
+	    makePlan (az_s, el_s);
+
+	// find pointing error in each dimension as a move from estimate to target
+	float az_err = azDist (kf_az.x, az_t);
+	float el_err = el_t - kf_el.x;
 
 	// correct each error using motor with most effect in that axis
 	MotorInfo *azmip = &motor[best_azmotor];
 	MotorInfo *elmip = &motor[!best_azmotor];
 
 	/*
-	Serial.print (F("Az:\t"));
-	    Serial.print(az_s); Serial.print(F("\t"));
-	    Serial.print(azmip->pos); Serial.print (F("\t"));
-	    Serial.print(az_err, 1); Serial.print (F("\t"));
-	    Serial.print(az_err*azmip->az_scale, 0);
-	Serial.print (F("\tEl:\t"));
-	    Serial.print(el_s); Serial.print(F("\t"));
-	    Serial.print(elmip->pos); Serial.print (F("\t"));
-	    Serial.print(el_err, 1); Serial.print (F("\t"));
-	    Serial.println(el_err*elmip->el_scale, 0);
+	DEBUG_SERIAL.print (F("Az:\t"));
+	    DEBUG_SERIAL.print(az_s); DEBUG_SERIAL.print(F("\t"));
+	    DEBUG_SERIAL.print(azmip->pos); DEBUG_SERIAL.print (F("\t"));
+	    DEBUG_SERIAL.print(az_err, 1); DEBUG_SERIAL.print (F("\t"));
+	    DEBUG_SERIAL.print(az_err*azmip->az_scale, 0);
+	DEBUG_SERIAL.print (F("\tEl:\t"));
+	    DEBUG_SERIAL.print(el_s); DEBUG_SERIAL.print(F("\t"));
+	    DEBUG_SERIAL.print(elmip->pos); DEBUG_SERIAL.print (F("\t"));
+	    DEBUG_SERIAL.print(el_err, 1); DEBUG_SERIAL.print (F("\t"));
+	    DEBUG_SERIAL.println(el_err*elmip->el_scale, 0);
 	*/
 
 
@@ -234,37 +422,53 @@ void Gimbal::seekTarget (float& az_t, float& el_t, float& az_s, float& el_s)
 	    float new_az_scale = azmip->del_pos/az_move;
 	    if (fabs((new_az_scale - azmip->az_scale)/azmip->az_scale) < MAX_CHANGE) 
 	    {
-		    Serial.print (F("New Az scale\t"));
-		    Serial.print (azmip->az_scale); Serial.print (F("\t->\t"));
-		    Serial.println(new_az_scale);
+		    DEBUG_SERIAL.print (F("New Az scale\t"));
+		    DEBUG_SERIAL.print (azmip->az_scale); DEBUG_SERIAL.print (F("\t->\t"));
+		    DEBUG_SERIAL.println(new_az_scale);
 		    azmip->az_scale = new_az_scale;
+		    scale_dirty = true;
 	    }
 	}
-	float el_move = el_s - prevstop_el;
+	float el_move = flipped ? prevstop_el - el_s : el_s - prevstop_el;
 	if (fabs(el_move) >= MIN_ANGLE) {
 	    float new_el_scale = elmip->del_pos/el_move;
 	    if (fabs((new_el_scale - elmip->el_scale)/elmip->el_scale) < MAX_CHANGE) {
-		Serial.print (F("New El scale\t"));
-		    Serial.print (elmip->el_scale); Serial.print (F("\t->\t"));
-		    Serial.println(new_el_scale);
+		DEBUG_SERIAL.print (F("New El scale\t"));
+		    DEBUG_SERIAL.print (elmip->el_scale); DEBUG_SERIAL.print (F("\t->\t"));
+		    DEBUG_SERIAL.println(new_el_scale);
 		elmip->el_scale = new_el_scale;
+		scale_dirty = true;
 	    }
 	}
 
+	// keep refinements, but not so often as to wear out the EEPROM
+	if (scale_dirty && millis() - scale_save_ms >= SCALE_SAVE_MS)
+	    saveScales();
+
+
+	// a planned pass already keeps clear of the limits
+	if (plan_ok) {
+	    followPlan (az_t, el_t, az_err, el_err);
+	    return;
+	}
+
+	// over the top el motor works backwards
+	if (flipped)
+	    el_err = -el_err;
 
 	// move each motor to reduce error, but if at Az limit then swing back to near opposite limit
   	if (azmip->atmin) {
-  	     Serial.println (F("At Az Min"));
+  	     DEBUG_SERIAL.println (F("At Az Min"));
   	    setMotorPosition (best_azmotor, azmip->min + 0.8*(azmip->max - azmip->min));
   	} else if (azmip->atmax) {
-  	     Serial.println (F("At Az Max"));
+  	     DEBUG_SERIAL.println (F("At Az Max"));
   	    setMotorPosition (best_azmotor, azmip->min + 0.2*(azmip->max - azmip->min));
   	} else
-        Serial.print("AZ_ERR: ");
-        Serial.print(az_err);
-        Serial.print(" EL_ERR: ");
-        Serial.print(az_err);
-        Serial.print("\n");
+        DEBUG_SERIAL.print("AZ_ERR: ");
+        DEBUG_SERIAL.print(az_err);
+        DEBUG_SERIAL.print(" EL_ERR: ");
+        DEBUG_SERIAL.print(az_err);
+        DEBUG_SERIAL.print("\n");
         if (az_err>GOOD_ERROR || az_err<-GOOD_ERROR)
         {
   	      setMotorPosition (best_azmotor, azmip->pos + az_err*azmip->az_scale);
@@ -276,6 +480,214 @@ void Gimbal::seekTarget (float& az_t, float& el_t, float& az_s, float& el_s)
 
 }
 
+/* advance the pointing estimate by the move just commanded to the given motor.
+ * the model is only as good as the scales, so a move before calibration just says we are lost.
+ * el is moved in the motor frame, where over the top it is 180 - el, so a move carrying the
+ * motor past the zenith brings el back down and turns az round.
+ */
+void Gimbal::filterPredict (uint8_t motn)
+{
+	if (!kf_ok)
+	    return;
+	MotorInfo *mip = &motor[motn];
+
+	if (!calibrated() || mip->az_scale == 0 || mip->el_scale == 0) {
+	    kf_az.p += KF_P_UNKNOWN;
+	    kf_el.p += KF_P_UNKNOWN;
+	    return;
+	}
+
+	float d_az = mip->del_pos/mip->az_scale;
+	float d_el = mip->del_pos/mip->el_scale;
+	float me = (flipped ? 180 - kf_el.x : kf_el.x) + d_el;
+	bool over = me > 90;
+	kf_el.x = over ? 180 - me : me;
+	kf_az.x = myfmod (kf_az.x + d_az + (over != flipped ? 180 : 0) + 360, 360);
+	kf_az.p += sq(KF_Q_MOVE*d_az);
+	kf_el.p += sq(KF_Q_MOVE*d_el);
+}
+
+/* correct the pointing estimate with the sensor sample az_m, el_m read at millis() ms.
+ * readings taken while the motors move are both lagging and disturbed by the servo magnets so
+ * they count for little. az is less certain towards the zenith.
+ */
+void Gimbal::filterUpdate (float az_m, float el_m, uint32_t ms)
+{
+	float cosel = cosf (radians (el_m));
+	float r_el = moving ? KF_R_MOVING : KF_R;
+	float r_az = r_el/fmaxf (cosel*cosel, 0.01F);
+
+	// first sample just seeds the estimate
+	if (!kf_ok) {
+	    kf_az.x = az_m;
+	    kf_az.p = r_az;
+	    kf_el.x = el_m;
+	    kf_el.p = r_el;
+	    kf_ms = ms;
+	    kf_ok = true;
+	    return;
+	}
+
+	// grow uncertainty for drift since the previous sample
+	float dt = (ms - kf_ms)/1000.0F;
+	kf_ms = ms;
+	kf_az.p += KF_Q_RATE*dt;
+	kf_el.p += KF_Q_RATE*dt;
+
+	// blend in the measurement according to the gain
+	float k = kf_az.p/(kf_az.p + r_az);
+	kf_az.x = myfmod (kf_az.x + k*azDist (kf_az.x, az_m) + 360, 360);
+	kf_az.p *= 1 - k;
+	k = kf_el.p/(kf_el.p + r_el);
+	kf_el.x += k*(el_m - kf_el.x);
+	kf_el.p *= 1 - k;
+}
+
+/* record the sky path of the next pass, or of the rest of this one if up now, to be planned
+ * when the motors next settle. a plan already being followed is kept to the end of its pass.
+ * n 0 drops any plan, such as when the target is set by hand.
+ */
+void Gimbal::planPass (const SkyPoint *sp, uint8_t n, bool up)
+{
+	if (n == 0) {
+	    npath = 0;
+	    plan_pending = plan_ok = false;
+	    return;
+	}
+	if (up && plan_ok)
+	    return;
+
+	npath = n < MAX_PATH ? n : MAX_PATH;
+	memcpy (path, sp, npath*sizeof(SkyPoint));
+	plan_pending = true;
+	plan_ok = plan_up = false;
+}
+
+/* choose how to follow path[] from the stopped position az_s, el_s: which turn of the az range
+ * and whether to go over the top. the choice keeping most points within the motor limits wins,
+ * then flipping only for high passes, where az would otherwise whip round near the zenith,
+ * then keeping PLAN_MARGIN clear of the az limits, lest the scales be a little off, then the
+ * least az move to get to the start.
+ */
+void Gimbal::makePlan (float &az_s, float &el_s)
+{
+	MotorInfo *azmip = &motor[best_azmotor];
+	MotorInfo *elmip = &motor[!best_azmotor];
+
+	// anchor the motor frame where we are
+	ref_pa = azmip->pos;
+	ref_pe = elmip->pos;
+	ref_ma = flipped ? az_s + 180 : az_s;
+	ref_me = flipped ? 180 - el_s : el_s;
+
+	float maxel = -90;
+	for (uint8_t i = 0; i < npath; i++)
+	    if (path[i].el > maxel)
+		maxel = path[i].el;
+	bool want_flip = maxel > FLIP_EL;
+
+	float best_score = 0;
+	bool found = false;
+	for (uint8_t f = 0; f < 2; f++) {
+	    for (int8_t k = -1; k <= 1; k++) {
+		float ma0, margin;
+		uint8_t n = planFits (f, k, ma0, margin);
+		float score = 1000.0F*n + (f == want_flip ? 500 : 0)
+			+ 400*fminf (fmaxf (margin, 0), PLAN_MARGIN)/PLAN_MARGIN - fabsf (ma0 - ref_ma);
+		if (!found || score > best_score) {
+		    found = true;
+		    best_score = score;
+		    plan_flip = f;
+		    plan_fits = n;
+		    plan_ma = ma0;
+		}
+	    }
+	}
+
+	plan_pending = false;
+	plan_ok = true;
+	plan_up = false;
+
+	DEBUG_SERIAL.print (F("Pass plan:\t"));
+	    DEBUG_SERIAL.print (plan_flip ? F("Flip") : F("Normal"));
+	    DEBUG_SERIAL.print (F("\tStart motor az:\t")); DEBUG_SERIAL.print (plan_ma);
+	    DEBUG_SERIAL.print (F("\tFits:\t")); DEBUG_SERIAL.print (plan_fits);
+	    DEBUG_SERIAL.print (F("/")); DEBUG_SERIAL.println (npath);
+}
+
+/* return how many path[] points are within the motor limits when followed over the top or not
+ * per flip, starting on the given extra turn of az. also return motor az at the first point and
+ * how close, in degs, the pass comes to an az limit. positions are extrapolated from the anchor
+ * with the calibrated scales, so allow GOOD_ERROR past a limit lest a pass rising right at the
+ * el limit count its ends as misses.
+ */
+uint8_t Gimbal::planFits (bool flip, int8_t turn, float &ma0, float &margin)
+{
+	MotorInfo *azmip = &motor[best_azmotor];
+	MotorInfo *elmip = &motor[!best_azmotor];
+
+	float ma = flip ? path[0].az + 180 : path[0].az;
+	float d = myfmod (ma - ref_ma + 720, 360);
+	ma = ref_ma + (d > 180 ? d - 360 : d) + 360*turn;
+	ma0 = ma;
+
+	float tol_a = GOOD_ERROR*fabsf (azmip->az_scale);
+	float tol_e = GOOD_ERROR*fabsf (elmip->el_scale);
+	float low = 1e9, high = -1e9;
+	uint8_t n = 0;
+	for (uint8_t i = 0; i < npath; i++) {
+	    if (i > 0)
+		ma += azDist (path[i-1].az, path[i].az);
+	    float e = fmaxf (path[i].el, 0);
+	    float me = flip ? 180 - e : e;
+	    float pa = ref_pa + (ma - ref_ma)*azmip->az_scale;
+	    float pe = ref_pe + (me - ref_me)*elmip->el_scale;
+	    if (pa >= azmip->min - tol_a && pa <= azmip->max + tol_a
+			    && pe >= elmip->min - tol_e && pe <= elmip->max + tol_e)
+		n++;
+	    low = fminf (low, pa);
+	    high = fmaxf (high, pa);
+	}
+	margin = fminf (low - azmip->min, azmip->max - high)/fabsf (azmip->az_scale);
+	return (n);
+}
+
+/* move towards az_t, el_t as the pass plan has it. the sensor errors az_err, el_err correct
+ * the planned positions, taking the turn of az nearest the plan, but if they disagree by a lot,
+ * or when first going over the top or back, go straight to the plan. flipped changes only once
+ * the moves are commanded so the estimate follows them in the frame they start from.
+ */
+void Gimbal::followPlan (float &az_t, float &el_t, float az_err, float el_err)
+{
+	MotorInfo *azmip = &motor[best_azmotor];
+	MotorInfo *elmip = &motor[!best_azmotor];
+
+	// planned motor az continues from the previous target
+	float d = myfmod ((plan_flip ? az_t + 180 : az_t) - plan_ma + 720, 360);
+	plan_ma += d > 180 ? d - 360 : d;
+	float e = fmaxf (el_t, 0);
+	float me = plan_flip ? 180 - e : e;
+	float pa = ref_pa + (plan_ma - ref_ma)*azmip->az_scale;
+	float pe = ref_pe + (me - ref_me)*elmip->el_scale;
+
+	// sensor correction on the planned turn
+	float turn = 360*azmip->az_scale;
+	float ca = azmip->pos + az_err*azmip->az_scale;
+	ca += turn*roundf ((pa - ca)/turn);
+	float ce = elmip->pos + (flipped ? -el_err : el_err)*elmip->el_scale;
+	bool turning = flipped != plan_flip;
+	if (turning || fabsf (ca - pa) > PLAN_SNAP*fabsf (azmip->az_scale))
+	    ca = pa;
+	if (turning || fabsf (ce - pe) > PLAN_SNAP*fabsf (elmip->el_scale))
+	    ce = pe;
+
+	if (fabsf (ca - azmip->pos) > GOOD_ERROR*fabsf (azmip->az_scale))
+	    setMotorPosition (best_azmotor, fmaxf (ca, 0) + 0.5F);
+	if (fabsf (ce - elmip->pos) > GOOD_ERROR*fabsf (elmip->el_scale))
+	    setMotorPosition (!best_azmotor, fmaxf (ce, 0) + 0.5F);
+	flipped = plan_flip;
+}
+
 /* given two azimuth values, return path length going shortest direction
  */
 float Gimbal::azDist (float &from, float &to)
@@ -314,6 +726,53 @@ void Gimbal::sendNewValues (WiFiClient client)
 	client.print (F("G_Mot2Min=")); client.println (motor[1].min);
 	client.print (F("G_Mot2Max=")); client.println (motor[1].max);
 
+	if (kf_ok) {
+	    client.print (F("G_EstAz=")); client.println (kf_az.x);
+	    client.print (F("G_EstEl=")); client.println (kf_el.x);
+	    client.print (F("G_EstSD=")); client.print (sqrtf (kf_az.p), 2);
+		client.print (F(" ")); client.println (sqrtf (kf_el.p), 2);
+	} else {
+	    client.println (F("G_EstAz="));
+	    client.println (F("G_EstEl="));
+	    client.println (F("G_EstSD="));
+	}
+
+	client.print (F("G_MaxVel=")); client.println (max_vel);
+	client.print (F("G_MaxAcc=")); client.println (max_acc);
+
+	client.print (F("G_LeadMs="));
+	if (lead_ms > 0)
+	    client.println (lead_ms, 0);
+	else
+	    client.println (F(""));
+	client.print (F("G_RMSErr="));
+	if (err_ok)
+	    client.println (sqrtf (err_sq), 2);
+	else
+	    client.println (F(""));
+
+	client.print (F("G_Plan="));
+	if (plan_ok) {
+	    client.print (plan_flip ? F("Flip") : F("Normal"));
+	    if (plan_fits < npath) {
+		client.print (F(", ")); client.print (npath - plan_fits);
+		client.println (F(" past limit!"));
+	    } else
+		client.println (F("+"));
+	} else if (plan_pending)
+	    client.println (F("Pending"));
+	else
+	    client.println (F("None"));
+	client.print (F("G_Flipped=")); client.println (flipped ? F("Yes") : F("No"));
+
+	client.print (F("G_SettleMs="));
+	if (moving)
+	    client.println (F("Moving"));
+	else if (settle_ms > 0)
+	    client.println (settle_ms);
+	else
+	    client.println (F(""));
+
 	client.print (F("G_Status="));
 	    if (motor[0].atmin)
 		client.println (F("1 at Min!"));
@@ -378,6 +837,25 @@ bool Gimbal::overrideValue (char *name, char *value)
 		webpage->setUserMessage (nog);
 	    return (true);
 	}
+	if (!strcmp (name, "G_MaxVel") || !strcmp (name, "G_MaxAcc")) {
+	    int v = atoi(value);
+	    if (!gimbal_found) {
+		webpage->setUserMessage (nog);
+	    } else if (v < 10 || v > 20000) {
+		webpage->setUserMessage (F("Servo limits must be 10 .. 20000!"));
+	    } else {
+		if (!strcmp (name, "G_MaxVel"))
+		    max_vel = v;
+		else
+		    max_acc = v;
+		nv->prof_vel = max_vel;
+		nv->prof_acc = max_acc;
+		nv->prof_ok = NV::VALID;
+		nv->put();
+		webpage->setUserMessage (F("Servo motion limits saved in EEPROM+"));
+	    }
+	    return (true);
+	}
 	if (!strcmp (name, "G_Mot2Max")) {
 	    if (gimbal_found) {
 		nv->mot1max = motor[1].max = atoi(value);
@@ -10,6 +10,7 @@
 #include "AutoSatTracker-ESP.h"
 #include "Target.h"
 #include "Sensor.h"
+#include "Control.h"
 
 class Gimbal {
 
@@ -29,6 +30,8 @@ class Gimbal {
 	    float az_scale, el_scale;			// az and el scale: steps (del usec) per degree
 	    uint16_t min, max;				// position limits, usec
 	    uint16_t pos;				// last commanded position, usec
+	    float out;					// position now being sent, usec, 0 until first
+	    float vel;					// rate out is changing, usec/sec
 	    int16_t del_pos;				// change in pos since previous move
 	    bool atmin, atmax;				// (would have been commanded to) limit
 	    uint8_t servo_num;				// I2C bus address 0..15
@@ -36,19 +39,85 @@ class Gimbal {
 	static const uint8_t NMOTORS = 2;		// not easily changed
 	MotorInfo motor[NMOTORS];
 
+	// motion profile, each motor ramps to pos within these limits rather than jumping
+	static const uint16_t MAX_VEL = 500;		// default max slew rate, usec/sec
+	static const uint16_t MAX_ACC = 1000;		// default max acceleration, usec/sec^2
+	uint16_t max_vel, max_acc;			// limits in use
+	uint32_t profile_ms;				// millis() of previous stepProfile()
+
 	// search info
 	// N.B.: max az physical motion must be < 180/CAL_FRAC
-	static const uint16_t UPD_PERIOD = 500;		// ms between updates
-	static constexpr float MAX_SETTLE = 5.0;	// considered stopped, degs
+	static const uint8_t SETTLE_N = 5;		// min samples since move to judge settling
+	static constexpr float MAX_SETTLE_VAR = 1.0;	// considered stopped, degs^2
 	static const uint8_t N_INIT_STEPS = 4;		// number of init_steps
 	static constexpr float CAL_FRAC = 0.333;	// fraction of full range to move for calibration
 							// N.B.: max physical motion must be < 180/CAL_FRAC
 	uint8_t init_step;				// initialization sequencing
 	uint8_t best_azmotor;				// after cal, motor[] index with most effect in az
-	uint32_t last_update;				// millis() time of last move
-	float prevfast_az, prevfast_el;			// previous pointing position
+	bool moving;					// motors commanded but not yet settled
+	uint32_t cmd_ms;				// millis() of last motor command
+	uint32_t move_ms;				// millis() a motor output last changed
+	uint32_t settle_ms;				// time taken by last move to settle, ms
 	float prevstop_az, prevstop_el;			// previous stopped position
 
+	// scales saved in EEPROM, checked at boot by a short move of both motors instead of init steps
+	static constexpr float VERIFY_FRAC = 0.1;	// fraction of full range to move for the check
+	static constexpr float VERIFY_TOL = 3.0;	// least disagreement allowed with saved scales, degs
+	static constexpr float VERIFY_REL = 0.2;	// or this fraction of the predicted move
+	static const uint32_t SCALE_SAVE_MS = 600000;	// least ms between saving refined scales
+	bool warm;					// starting from saved scales
+	float verify_az, verify_el;			// check move predicted by saved scales, degs
+	bool scale_dirty;				// scales refined since last saved
+	uint32_t scale_save_ms;				// millis() scales were last saved
+	void saveScales();
+
+	// pointing estimate fusing the commanded motor moves with the sensor, one filter per axis
+	static constexpr float KF_R = 1.0;		// sensor variance when still, degs^2
+	static constexpr float KF_R_MOVING = 100.0;	// sensor variance while motors move, degs^2
+	static constexpr float KF_Q_RATE = 0.1;		// drift variance growth, degs^2/sec
+	static constexpr float KF_Q_MOVE = 0.1;		// model error as fraction of predicted move
+	static constexpr float KF_P_UNKNOWN = 1e4;	// variance added by a move with no model, degs^2
+	typedef struct {
+	    float x;					// estimate, degs
+	    float p;					// its variance, degs^2
+	} AxisFilter;
+	AxisFilter kf_az, kf_el;
+	bool kf_ok;					// set once seeded from the sensor
+	uint32_t kf_ms;					// millis() of last sensor sample used
+	void filterPredict (uint8_t motn);
+	void filterUpdate (float az_m, float el_m, uint32_t ms);
+
+	// feed forward of target motion, and how well we follow it
+	static constexpr float MAX_LEAD = 45.0;		// largest lead in either axis, degs
+	static constexpr float LAT_ALPHA = 0.2;		// weight of each new settle time in lat_ms
+	static constexpr float ERR_ALPHA = 0.01;	// weight of each new sample in err_sq
+	float lat_ms;					// smoothed settle_ms, 0 until first
+	float lead_ms;					// how far ahead of the target to aim, ms
+	float err_sq;					// smoothed square pointing error, degs^2
+	bool err_ok;					// whether err_sq has been seeded
+
+	// pass plan: which turn of the az range, and whether to go over the top with el past the
+	// zenith, so the whole pass is followed without reaching a limit. planned in motor frame
+	// where flipped az is turned round 180 and el is 180 - el.
+	static const uint8_t MAX_PATH = 20;		// most sky path points kept, as Target
+	static constexpr float FLIP_EL = 75.0;		// prefer flipping for passes higher than this, degs
+	static constexpr float PLAN_SNAP = 45.0;	// go straight to plan if further than this, degs
+	static constexpr float PLAN_MARGIN = 10.0;	// az room wanted at the limits, degs
+	SkyPoint path[MAX_PATH];			// pass to plan, from Target
+	uint8_t npath;					// n points in path[]
+	bool plan_pending;				// path is new, plan when next settled
+	bool plan_ok;					// following the plan
+	bool plan_up;					// pass has risen since planned
+	bool plan_flip;					// plan goes over the top
+	uint8_t plan_fits;				// n path points plan keeps within limits
+	float plan_ma;					// motor az of last planned point, unwrapped, degs
+	float ref_ma, ref_me;				// motor az and el where plan is anchored, degs
+	uint16_t ref_pa, ref_pe;			// az and el motor positions there, usec
+	bool flipped;					// whether the motors are now over the top
+	void makePlan (float &az_s, float &el_s);
+	uint8_t planFits (bool flip, int8_t turn, float &ma0, float &margin);
+	void followPlan (float &az_t, float &el_t, float az_err, float el_err);
+
 	void setMotorPosition (uint8_t motn, uint16_t newpos);
 	void calibrate (float &az_s, float &el_s);
 	void seekTarget (float& az_t, float& el_t, float& az_s, float& el_s);
@@ -58,7 +127,11 @@ class Gimbal {
 
 	Gimbal();
 
-	void moveToAzEl (float az_t, float el_t);
+	void estimate();
+	void stepProfile();
+	void moveToAzEl (float az_t, float el_t, float az_rate, float el_rate, float az_acc, float el_acc);
+	void planPass (const SkyPoint *sp, uint8_t n, bool up);
+	static float leadAngle (float rate, float acc, float lead_ms);
 	void sendNewValues (WiFiClient client);
 	bool overrideValue (char *name, char *value);
 	bool connected() { return (gimbal_found); };
@@ -18,11 +18,14 @@ class NV {
 	enum {
 	    MAGIC  = 0x5a5aa5a5,
 	    NBNO055CALBYTES = 22,
-	    EEBYTES = 250,
+	    EEBYTES = 512,
 	};
 
     public:
 
+	// value of a valid flag for a group added after the magic cookie was set
+	static const uint8_t VALID = 0xa5;
+
 	// these variables are stored in EEPROM
 	uint32_t magic;
 	IPAddress IP, GW, NM;
@@ -30,6 +33,18 @@ class NV {
 	char pw[64];
 	uint16_t mot0min, mot0max, mot1min, mot1max;
 	uint8_t BNO055cal[NBNO055CALBYTES];
+	float sunbore[3];		// antenna boresight in sensor body frame found from the sun
+	float sunhead;			// heading correction found with it, degs
+	uint8_t sunalign_ok;		// VALID if sunbore and sunhead are
+	float tempcomp[2];		// heading correction, degs + degs/C * temperature
+	uint8_t tempcomp_ok;		// VALID if tempcomp is
+	uint16_t ctrl_ms[3];		// Control sense, estimate and actuate periods
+	uint8_t ctrl_ok;		// VALID if ctrl_ms are
+	uint16_t prof_vel, prof_acc;	// Gimbal motion limits, usec/sec and usec/sec^2
+	uint8_t prof_ok;		// VALID if prof_vel and prof_acc are
+	float mot_scale[2][2];		// Gimbal az and el scale of each motor, usec/deg
+	uint8_t best_azmotor;		// Gimbal motor with most effect in az
+	uint8_t scale_ok;		// VALID if mot_scale and best_azmotor are
 
 	NV() {
 	    EEPROM.begin(EEBYTES);
@@ -177,29 +177,46 @@ DateTime::diff (DateTime& t0)
 //                                                      
 //----------------------------------------------------------------------
 
+Observer::Observer()
+{
+    update(0., 0., 0.) ;
+}
+
 Observer::Observer(float lat, float lng, float hgt)
+{
+    update(lat, lng, hgt) ;
+}
+
+// recompute everything in place for a new location so a long-lived
+// Observer can follow a moving station without touching the heap.
+// U, E and N are the rows of the ECEF to up/east/north rotation, O is
+// the station position and V its velocity due to earth rotation.
+void
+Observer::update(float lat, float lng, float hgt)
 {
     LA = RADIANS(lat) ;
     LO = RADIANS(lng) ;
     HT = hgt / 1000 ;
 
-    U[0] = cos(LA)*cos(LO) ;
-    U[1] = cos(LA)*sin(LO) ;
-    U[2] = sin(LA) ;
+    float CL = cos(LA), SL = sin(LA) ;
+    float CO = cos(LO), SO = sin(LO) ;
+
+    U[0] = CL*CO ;
+    U[1] = CL*SO ;
+    U[2] = SL ;
 
-    E[0] = -sin(LO) ;
-    E[1] =  cos(LO) ;
+    E[0] = -SO ;
+    E[1] =  CO ;
     E[2] =  0. ;
 
-    N[0] = -sin(LA)*cos(LO) ;
-    N[1] = -sin(LA)*sin(LO) ;
-    N[2] =  cos(LA) ;
+    N[0] = -SL*CO ;
+    N[1] = -SL*SO ;
+    N[2] =  CL ;
 
     float RP = RE * (1 - FL) ;
     float XX = RE * RE ;
     float ZZ = RP * RP ;
-    float D = sqrt(XX*cos(LA)*cos(LA) + 
-	            ZZ*sin(LA)*sin(LA)) ;
+    float D = sqrt(XX*CL*CL + ZZ*SL*SL) ;
     float Rx = XX / D + HT ;
     float Rz = ZZ / D + HT ;
 
@@ -453,3 +470,16 @@ Sun::predict(const DateTime &dt)
     H[1]=SUN[0]*S + SUN[1]*C ;
     H[2]=SUN[2] ;
 }
+
+void
+Sun::topo(const Observer *obs, float &alt, float &az)
+{
+    // the sun is far enough away that its direction is the same from anywhere on earth
+    float u = H[0] * obs->U[0] + H[1] * obs->U[1] + H[2] * obs->U[2] ;
+    float e = H[0] * obs->E[0] + H[1] * obs->E[1] + H[2] * obs->E[2] ;
+    float n = H[0] * obs->N[0] + H[1] * obs->N[1] + H[2] * obs->N[2] ;
+
+    az = DEGREES(atan2(e, n)) ;
+    if (az < 0.) az += 360. ;
+    alt = DEGREES(asin(u)) ;
+}
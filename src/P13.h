@@ -76,8 +76,10 @@ public:
     float HT ;
     Vec3 U, E, N, O, V  ;
     
+    Observer() ;
     Observer(float, float, float) ;
     ~Observer() { } ;
+    void update(float, float, float) ;
 } ;
 
 //----------------------------------------------------------------------
@@ -89,6 +91,7 @@ public:
 	Sun() ;
 	~Sun() { } ;
         void predict(const DateTime &dt) ;
+	void topo(const Observer *obs, float &alt, float &az);
 } ;
 
 //----------------------------------------------------------------------
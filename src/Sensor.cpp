@@ -2,6 +2,33 @@
  */
 
 #include "Sensor.h"
+#include "Control.h"
+
+/* antenna boresight in antenna frame, then the rotation from antenna frame to sensor body frame.
+ * with the Adafruit board mounted as described at readSample() the boresight is body -Y and
+ * the mount rotation is identity. change MOUNT if the board is mounted any other way.
+ */
+static const float BORE[3] = {0, -1, 0};
+static const float MOUNT[3][3] = {
+    {1, 0, 0},
+    {0, 1, 0},
+    {0, 0, 1},
+};
+
+/* find the antenna boresight in body frame b as mounted
+ */
+static void mountBore (float b[3])
+{
+	for (uint8_t i = 0; i < 3; i++)
+	    b[i] = MOUNT[i][0]*BORE[0] + MOUNT[i][1]*BORE[1] + MOUNT[i][2]*BORE[2];
+}
+
+/* return the signed little-endian 16 bit value in r[0..1]
+ */
+static int16_t reg16 (const uint8_t *r)
+{
+	return ((int16_t)(((uint16_t)r[1] << 8) | r[0]));
+}
 
 /* class constructor
  */
@@ -13,18 +40,195 @@ Sensor::Sensor()
 	resetWatchdog();
 	sensor_found = bno->begin(Adafruit_BNO055::OPERATION_MODE_NDOF);
 	if (sensor_found)
-	    Serial.println (F("Sensor found ok"));
+	    DEBUG_SERIAL.println (F("Sensor found ok"));
 	else
-	    Serial.println (F("Sensor not found"));
+	    DEBUG_SERIAL.println (F("Sensor not found"));
+
+	// no bus traffic yet
+	i2c_n = 0;
+	i2c_m0 = millis();
+	i2c_rate = 0;
+	i2c_errors = 0;
+
 	installCalibration();
+
+	// boresight and heading from the sun if we have them, else as mounted
+	nv->get();
+	nsuncal = 0;
+	align_rms = 0;
+	align_ok = nv->sunalign_ok == NV::VALID;
+	if (align_ok) {
+	    memcpy (bore, nv->sunbore, sizeof(bore));
+	    head = nv->sunhead;
+	} else {
+	    mountBore (bore);
+	    head = 0;
+	}
+	templog = new circular_queue<SunPoint>(TEMPLOG_MAX);
+	tempcomp_ok = nv->tempcomp_ok == NV::VALID;
+	tempcomp[0] = tempcomp_ok ? nv->tempcomp[0] : 0;
+	tempcomp[1] = tempcomp_ok ? nv->tempcomp[1] : 0;
+	tempcomp_rms = 0;
+
+	// no readings yet
+	memset (&sample, 0, sizeof(sample));
+	sampled = false;
+	history = new circular_queue<Point>(HISTORY_N);
+}
+
+/* read a fresh sample, Control calls this at the sensing rate.
+ */
+void Sensor::update()
+{
+	if (!sensor_found)
+	    return;
+
+	readSample();
+	sampled = true;
+
+	// update bus rate
+	uint32_t now = millis();
+	if (now - i2c_m0 >= 10000) {
+	    i2c_rate = 1000.0F*i2c_n/(now - i2c_m0);
+	    i2c_n = 0;
+	    i2c_m0 = now;
+	}
+}
+
+/* read n consecutive registers starting at reg into buf in one transaction.
+ * return whether all arrived.
+ */
+bool Sensor::readRegs (uint8_t reg, uint8_t *buf, uint8_t n)
+{
+	i2c_n++;
+	Wire.beginTransmission((uint8_t)BNO055_I2CADDR);
+	Wire.write(reg);
+	bool ok = Wire.endTransmission(false) == 0			// repeated start
+		    && Wire.requestFrom((uint8_t)BNO055_I2CADDR, n) == n;
+	for (uint8_t i = 0; i < n && Wire.available(); i++)
+	    buf[i] = Wire.read();
+	if (!ok)
+	    i2c_errors++;
+	return (ok);
 }
 
-/* read the current temperature, in degrees C
+/* write n bytes from buf to consecutive registers starting at reg in one transaction.
+ * return whether the sensor acknowledged them all.
+ */
+bool Sensor::writeRegs (uint8_t reg, const uint8_t *buf, uint8_t n)
+{
+	i2c_n++;
+	Wire.beginTransmission((uint8_t)BNO055_I2CADDR);
+	Wire.write(reg);
+	Wire.write(buf, n);
+	bool ok = Wire.endTransmission() == 0;
+	if (!ok)
+	    i2c_errors++;
+	return (ok);
+}
+
+/* read the sensor direction into sample, corrected for mag decl but not necessarily calibrated.
+ * the orientation quaternion is used rather than euler angles because those lose roll and heading
+ * near 90 degrees pitch, which is just where we need them as a pass goes overhead.
+ * N.B. Adafruit board:
+ *   the short dimension is parallel to the antenna boom,
+ *   the populated side of the board faces upwards and
+ *   the side with the control signals (SDA, SCL etc) points in the rear direction of the antenna pattern.
+ * Note that az/el is a left-hand coordinate system.
+ */
+void Sensor::readSample()
+{
+	Wire.setClockStretchLimit(2000);
+	uint8_t r[SAMPLE_NREGS];
+	if (!readRegs (SAMPLE_REG0, r, sizeof(r)))
+	    return;				// keep previous, age will show it
+
+	// all little-endian, see datasheet 3.6.5
+	const float qscale = 1.0F/(1 << 14);
+	imu::Quaternion q (qscale*reg16(&r[0]), qscale*reg16(&r[2]), qscale*reg16(&r[4]), qscale*reg16(&r[6]));
+	for (uint8_t i = 0; i < 3; i++) {
+	    sample.lia[i] = 0.01F*reg16(&r[8+2*i]);
+	    sample.grv[i] = 0.01F*reg16(&r[14+2*i]);
+	}
+	sample.temp = (int8_t)r[20];
+	uint8_t cal = r[21];
+	sample.sys = (cal >> 6) & 3;
+	sample.gyro = (cal >> 4) & 3;
+	sample.accel = (cal >> 2) & 3;
+	sample.mag = cal & 3;
+
+	// boresight as seen by the sensor, then corrected for heading
+	sample.q[0] = q.w();
+	sample.q[1] = q.x();
+	sample.q[2] = q.y();
+	sample.q[3] = q.z();
+	boreENU (q, bore, sample.v);
+
+	float az, el;
+	enuAzEl (sample.v, az, el);
+	sample.az = myfmod (az + circum->magdeclination + head + tempcomp[0] + tempcomp[1]*sample.temp
+			+ 720, 360);
+	sample.el = el;
+	sample.ms = millis();
+
+	// add to history, making room by dropping the oldest
+	Point p;
+	p.az = sample.az;
+	p.el = sample.el;
+	p.ms = sample.ms;
+	if (!history->available_for_push())
+	    history->pop();
+	history->push (p);
+}
+
+/* find the East, North, Up unit vector v of body vector b after rotating by unit quaternion q.
+ * q is taken to rotate the body frame into a world frame of East, North, Up.
+ */
+void Sensor::boreENU (const imu::Quaternion &q, const float b[3], float v[3])
+{
+	float qw = q.w(), qx = q.x(), qy = q.y(), qz = q.z();
+
+	// v = b + 2w(q x b) + q x 2(q x b)
+	float tx = 2*(qy*b[2] - qz*b[1]);
+	float ty = 2*(qz*b[0] - qx*b[2]);
+	float tz = 2*(qx*b[1] - qy*b[0]);
+	v[0] = b[0] + qw*tx + (qy*tz - qz*ty);
+	v[1] = b[1] + qw*ty + (qz*tx - qx*tz);
+	v[2] = b[2] + qw*tz + (qx*ty - qy*tx);
+
+	// allow for q not being quite unit length
+	float r = sqrtf (v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+	if (r > 0)
+	    for (uint8_t i = 0; i < 3; i++)
+		v[i] /= r;
+}
+
+/* find the az and el, in degrees, of East, North, Up unit vector v.
+ * az is undefined straight up, where we return 0.
+ * N.B. el from atan2 not asin, which can not tell the last 0.02 degrees below the zenith apart in float
+ */
+void Sensor::enuAzEl (const float v[3], float &az, float &el)
+{
+	el = degrees (atan2f (v[2], hypotf (v[0], v[1])));
+	az = (v[0] == 0 && v[1] == 0) ? 0 : degrees (atan2f (v[0], v[1]));
+}
+
+/* find the East, North, Up unit vector v of the given az and el, in degrees.
+ */
+void Sensor::azElENU (float az, float el, float v[3])
+{
+	float cosel = cosf (radians (el));
+	v[0] = cosel*sinf (radians (az));
+	v[1] = cosel*cosf (radians (az));
+	v[2] = sinf (radians (el));
+}
+
+/* return the most recent temperature, in degrees C
  */
 int8_t Sensor::getTempC()
 {
 	if (sensor_found)
-	    return bno->getTemp();
+	    return (sample.temp);
 	return (-1);
 }
 
@@ -35,28 +239,303 @@ bool Sensor::calibrated(uint8_t& sys, uint8_t& gyro, uint8_t& accel, uint8_t& ma
 	if (!sensor_found)
 	    return (false);
 
-	sys = 0;
-	gyro = 0;
-	accel = 0;
-	mag = 0;;
-	bno->getCalibration(&sys, &gyro, &accel, &mag);
+	sys = sample.sys;
+	gyro = sample.gyro;
+	accel = sample.accel;
+	mag = sample.mag;
 	return (sys >= 1 && gyro >= 1 && accel >= 1 && mag >= 1);
 }
 
-/* read the current az and el, corrected for mag decl but not necessarily calibrated.
+/* return the most recent az and el, corrected for mag decl but not necessarily calibrated,
+ * and its age in ms.
  * N.B. we assume this will only be called if we know the sensor is connected.
- * N.B. Adafruit board:
- *   the short dimension is parallel to the antenna boom,
- *   the populated side of the board faces upwards and
- *   the side with the control signals (SDA, SCL etc) points in the rear direction of the antenna pattern.
- * Note that az/el is a left-hand coordinate system.
  */
-void Sensor::getAzEl (float *azp, float *elp)
+uint32_t Sensor::getAzEl (float *azp, float *elp)
 {
-	Wire.setClockStretchLimit(2000);
-	imu::Vector<3> euler = bno->getVector(Adafruit_BNO055::VECTOR_EULER);
-	*azp = myfmod (euler.x() + circum->magdeclination + 540, 360);
-	*elp = euler.z();
+	if (!sampled)
+	    update();
+	*azp = sample.az;
+	*elp = sample.el;
+	return (millis() - sample.ms);
+}
+
+/* fill w with the median, mean and variance of the samples read after since_ms.
+ * return false if there are fewer than 2 such samples.
+ */
+bool Sensor::getWindow (Window &w, uint32_t since_ms)
+{
+	float az[HISTORY_N], el[HISTORY_N];
+	uint8_t n = 0;
+
+	// collect newest to oldest, az as offsets from the newest
+	float az0 = 0;
+	history->for_each_rev_requeue ([&](Point &p) {
+	    if (n < HISTORY_N && (int32_t)(p.ms - since_ms) > 0) {
+		if (n == 0)
+		    az0 = p.az;
+		float d = p.az - az0;
+		if (d < -180)
+		    d += 360;
+		else if (d > 180)
+		    d -= 360;
+		az[n] = d;
+		el[n] = p.el;
+		n++;
+	    }
+	    return (true);			// keep them all
+	});
+	w.n = n;
+	if (n < 2)
+	    return (false);
+
+	// mean and variance
+	float az_sum = 0, el_sum = 0;
+	for (uint8_t i = 0; i < n; i++) {
+	    az_sum += az[i];
+	    el_sum += el[i];
+	}
+	w.az_mean = az_sum/n;
+	w.el_mean = el_sum/n;
+	float az_ss = 0, el_ss = 0;
+	for (uint8_t i = 0; i < n; i++) {
+	    az_ss += sq(az[i] - w.az_mean);
+	    el_ss += sq(el[i] - w.el_mean);
+	}
+	w.az_var = az_ss/(n-1);
+	w.el_var = el_ss/(n-1);
+
+	// median, insertion sort is plenty for so few
+	for (uint8_t i = 1; i < n; i++) {
+	    float a = az[i], e = el[i];
+	    int8_t j;
+	    for (j = i-1; j >= 0 && az[j] > a; j--)
+		az[j+1] = az[j];
+	    az[j+1] = a;
+	    for (j = i-1; j >= 0 && el[j] > e; j--)
+		el[j+1] = el[j];
+	    el[j+1] = e;
+	}
+	w.az_med = (n & 1) ? az[n/2] : (az[n/2-1] + az[n/2])/2;
+	w.el_med = (n & 1) ? el[n/2] : (el[n/2-1] + el[n/2])/2;
+
+	// back to real az
+	w.az_med = myfmod (w.az_med + az0 + 360, 360);
+	w.az_mean = myfmod (w.az_mean + az0 + 360, 360);
+
+	return (true);
+}
+
+/* find where the sun is now.
+ * return whether it is high enough to align with.
+ */
+bool Sensor::sunAzEl (float &az, float &el)
+{
+	Sun sun;
+	DateTime now (circum->now());
+	sun.predict (now);
+	sun.topo (circum->observer(), el, az);
+	return (el >= SUNCAL_MINEL);
+}
+
+/* record the current pointing, which the operator says is on the sun, as an alignment point.
+ * return whether it was recorded.
+ */
+bool Sensor::addSunPoint()
+{
+	float az, el;
+	if (!sunAzEl (az, el)) {
+	    webpage->setUserMessage (F("Sun is too low to align with!"));
+	    return (false);
+	}
+	if (nsuncal >= SUNCAL_MAX) {
+	    webpage->setUserMessage (F("Sun points are full, Solve or Clear!"));
+	    return (false);
+	}
+
+	// orientation as read, sun turned to the same magnetic frame
+	SunPoint *sp = &suncal[nsuncal++];
+	memcpy (sp->q, sample.q, sizeof(sp->q));
+	azElENU (az - circum->magdeclination, el, sp->s);
+	sp->temp = sample.temp;
+
+	// also log for the temperature fit
+	if (!templog->available_for_push())
+	    templog->pop();
+	templog->push (*sp);
+
+	webpage->setUserMessage (F("Sun point recorded+"));
+	return (true);
+}
+
+/* find the body frame boresight and the heading correction that best put the pointing on the
+ * sun at each sun point, then use them and save them in EEPROM. each is found in turn given the
+ * other: the boresight is the mean of the sun directions turned back into the body frame, the
+ * heading is the mean az error left, weighted down towards the zenith where az says little.
+ * return whether they could be found.
+ */
+bool Sensor::solveSunAlign()
+{
+	// need directions well apart or the heading and boresight can not be told apart
+	float mindot = 1;
+	for (uint8_t i = 0; i < nsuncal; i++) {
+	    for (uint8_t j = i+1; j < nsuncal; j++) {
+		float d = suncal[i].s[0]*suncal[j].s[0] + suncal[i].s[1]*suncal[j].s[1]
+				+ suncal[i].s[2]*suncal[j].s[2];
+		if (d < mindot)
+		    mindot = d;
+	    }
+	}
+	if (nsuncal < 2 || mindot > cosf (radians (SUNCAL_MINSEP))) {
+	    webpage->setUserMessage (F("Need Sun points farther apart in time!"));
+	    return (false);
+	}
+
+	// aim for the sun less whatever heading the temperature compensation will add
+	float s_az[SUNCAL_MAX], s_el[SUNCAL_MAX];
+	for (uint8_t i = 0; i < nsuncal; i++) {
+	    enuAzEl (suncal[i].s, s_az[i], s_el[i]);
+	    s_az[i] -= tempcomp[0] + tempcomp[1]*suncal[i].temp;
+	}
+
+	float b[3], h = 0;
+	for (uint8_t iter = 0; iter < SUNCAL_ITERS; iter++) {
+
+	    // boresight given heading
+	    b[0] = b[1] = b[2] = 0;
+	    for (uint8_t i = 0; i < nsuncal; i++) {
+		const float *q = suncal[i].q;
+		float s[3], u[3];
+		azElENU (s_az[i] - h, s_el[i], s);
+		boreENU (imu::Quaternion (q[0], q[1], q[2], q[3]).conjugate(), s, u);
+		for (uint8_t a = 0; a < 3; a++)
+		    b[a] += u[a];
+	    }
+	    float r = sqrtf (b[0]*b[0] + b[1]*b[1] + b[2]*b[2]);
+	    if (r == 0) {
+		webpage->setUserMessage (F("Sun points disagree, Clear and try again!"));
+		return (false);
+	    }
+	    for (uint8_t a = 0; a < 3; a++)
+		b[a] /= r;
+
+	    // heading given boresight
+	    float sw = 0, se = 0;
+	    for (uint8_t i = 0; i < nsuncal; i++) {
+		const float *q = suncal[i].q;
+		float m[3], m_az, m_el;
+		boreENU (imu::Quaternion (q[0], q[1], q[2], q[3]), b, m);
+		enuAzEl (m, m_az, m_el);
+		float e = myfmod (s_az[i] - m_az + 540, 360) - 180;
+		float w = sq(cosf (radians (s_el[i])));
+		sw += w;
+		se += w*e;
+	    }
+	    h = sw > 0 ? se/sw : 0;
+	}
+	memcpy (bore, b, sizeof(bore));
+	head = h;
+	align_ok = true;
+
+	// rms angle remaining between each corrected pointing and the sun, atan2 to keep small ones
+	float sum = 0;
+	for (uint8_t i = 0; i < nsuncal; i++) {
+	    const float *q = suncal[i].q;
+	    float m[3], m_az, m_el, v[3], s[3];
+	    boreENU (imu::Quaternion (q[0], q[1], q[2], q[3]), bore, m);
+	    enuAzEl (m, m_az, m_el);
+	    azElENU (m_az + head, m_el, v);
+	    azElENU (s_az[i], s_el[i], s);
+	    float c[3] = {v[1]*s[2] - v[2]*s[1], v[2]*s[0] - v[0]*s[2], v[0]*s[1] - v[1]*s[0]};
+	    float d = v[0]*s[0] + v[1]*s[1] + v[2]*s[2];
+	    sum += sq(degrees (atan2f (sqrtf (c[0]*c[0] + c[1]*c[1] + c[2]*c[2]), d)));
+	}
+	align_rms = sqrtf (sum/nsuncal);
+
+	// save
+	memcpy (nv->sunbore, bore, sizeof(bore));
+	nv->sunhead = head;
+	nv->sunalign_ok = NV::VALID;
+	nv->put();
+	webpage->setUserMessage (F("Sun alignment saved in EEPROM+"));
+	return (true);
+}
+
+/* forget all sun points and any alignment, here and in EEPROM.
+ */
+void Sensor::clearSunAlign()
+{
+	nsuncal = 0;
+	align_ok = false;
+	align_rms = 0;
+	mountBore (bore);
+	head = 0;
+
+	nv->sunalign_ok = 0;
+	nv->put();
+	webpage->setUserMessage (F("Sun alignment cleared+"));
+}
+
+/* fit the heading error left after alignment to a line in temperature, then use it and save
+ * it in EEPROM. points towards the zenith say little about heading so count for less.
+ * return whether it could be found.
+ */
+bool Sensor::fitTempComp()
+{
+	// weighted sums for the normal equations
+	float sw = 0, st = 0, stt = 0, se = 0, ste = 0, see = 0;
+	int8_t tmin = 127, tmax = -128;
+	templog->for_each_rev_requeue ([&](SunPoint &p) {
+	    float m[3], m_az, m_el, s_az, s_el;
+	    boreENU (imu::Quaternion (p.q[0], p.q[1], p.q[2], p.q[3]), bore, m);
+	    enuAzEl (m, m_az, m_el);
+	    enuAzEl (p.s, s_az, s_el);
+	    float e = myfmod (s_az - m_az - head + 540, 360) - 180;
+	    float w = sq(cosf (radians (s_el)));
+	    float t = p.temp;
+	    sw += w;
+	    st += w*t;
+	    stt += w*t*t;
+	    se += w*e;
+	    ste += w*t*e;
+	    see += w*e*e;
+	    if (p.temp < tmin)
+		tmin = p.temp;
+	    if (p.temp > tmax)
+		tmax = p.temp;
+	    return (true);
+	});
+	float det = sw*stt - st*st;
+	if (tmax - tmin < TEMPLOG_MINSPREAD || det <= 0) {
+	    webpage->setUserMessage (F("Need Sun points over a wider temperature range!"));
+	    return (false);
+	}
+
+	tempcomp[1] = (sw*ste - st*se)/det;
+	tempcomp[0] = (se - tempcomp[1]*st)/sw;
+	tempcomp_ok = true;
+	tempcomp_rms = sqrtf (fmaxf (see - tempcomp[0]*se - tempcomp[1]*ste, 0)/sw);
+
+	// save
+	nv->tempcomp[0] = tempcomp[0];
+	nv->tempcomp[1] = tempcomp[1];
+	nv->tempcomp_ok = NV::VALID;
+	nv->put();
+	webpage->setUserMessage (F("Temperature compensation saved in EEPROM+"));
+	return (true);
+}
+
+/* forget the temperature log and any compensation, here and in EEPROM.
+ */
+void Sensor::clearTempComp()
+{
+	templog->flush();
+	tempcomp[0] = tempcomp[1] = 0;
+	tempcomp_ok = false;
+	tempcomp_rms = 0;
+
+	nv->tempcomp_ok = 0;
+	nv->put();
+	webpage->setUserMessage (F("Temperature compensation cleared+"));
 }
 
 /* process name = value pair
@@ -65,8 +544,30 @@ void Sensor::getAzEl (float *azp, float *elp)
 bool Sensor::overrideValue (char *name, char *value)
 {
 	if (!strcmp (name, "SS_Save")) {
-	    saveCalibration();
-	    webpage->setUserMessage (F("Sensor calibrations saved to EEPROM+"));
+	    if (saveCalibration())
+		webpage->setUserMessage (F("Sensor calibrations saved to EEPROM+"));
+	    else
+		webpage->setUserMessage (F("Sensor calibrations could not be read!"));
+	    return (true);
+	}
+
+	if (!strcmp (name, "SS_SunCal")) {
+	    if (!sensor_found)
+		webpage->setUserMessage (F("No sensor!"));
+	    else if (!strcasecmp (value, "Point"))
+		target->pointAtSun();
+	    else if (!strcasecmp (value, "Add"))
+		addSunPoint();
+	    else if (!strcasecmp (value, "Solve"))
+		solveSunAlign();
+	    else if (!strcasecmp (value, "Clear"))
+		clearSunAlign();
+	    else if (!strcasecmp (value, "TempFit"))
+		fitTempComp();
+	    else if (!strcasecmp (value, "TempClear"))
+		clearTempComp();
+	    else
+		webpage->setUserMessage (F("Sun commands are Point, Add, Solve, Clear, TempFit or TempClear!"));
 	    return (true);
 	}
 
@@ -85,9 +586,11 @@ void Sensor::sendNewValues (WiFiClient client)
 	}
 
 	float az, el;
-	getAzEl (&az, &el);
+	uint32_t age = getAzEl (&az, &el);
 	client.print (F("SS_Az=")); client.println (az);
 	client.print (F("SS_El=")); client.println (el);
+	client.print (F("SS_Age=")); client.print (age);
+	    client.println (age > 2U*control->period(Control::SENSE) ? F("!") : F(""));
 
 	uint8_t sys, gyro, accel, mag;
 	bool calok = calibrated (sys, gyro, accel, mag);
@@ -108,50 +611,80 @@ void Sensor::sendNewValues (WiFiClient client)
 
 	client.print (F("SS_Temp="));
 	client.println (getTempC());
+
+	client.print (F("SS_I2CRate=")); client.print (i2c_rate, 1);
+	    client.println (i2c_errors > 0 ? F("!") : F(""));
+	client.print (F("SS_I2CErr=")); client.println (i2c_errors);
+
+	client.print (F("SS_SunCal="));
+	    client.print (nsuncal); client.print (F(" pts, "));
+	    if (align_ok) {
+		client.print (F("On"));
+		if (align_rms > 0) {
+		    client.print (F(" rms ")); client.print (align_rms, 2);
+		}
+		client.println (F("+"));
+	    } else
+		client.println (F("Off"));
+	float sun_az, sun_el;
+	bool sun_ok = sunAzEl (sun_az, sun_el);
+	client.print (F("SS_SunAzEl=")); client.print (sun_az, 1);
+	    client.print (F(" ")); client.print (sun_el, 1);
+	    client.println (sun_ok ? F("") : F("!"));
+
+	client.print (F("SS_TempComp="));
+	    if (tempcomp_ok) {
+		client.print (tempcomp[0], 2); client.print (F(" ")); client.print (tempcomp[1], 3);
+		if (tempcomp_rms > 0) {
+		    client.print (F(" rms ")); client.print (tempcomp_rms, 2);
+		}
+		client.println (F("+"));
+	    } else
+		client.println (F("Off"));
+	client.print (F("SS_TempLog=")); client.println (templog->available());
 }
 
 /* read the sensor calibration values and save into EEPROM.
+ * return whether they were all read, EEPROM is left alone if not.
+ * N.B. setMode() already waits longer than the datasheet mode switching times.
  * Wanted to stick with stock Adafruit lib so pulled from
  * post by protonstorm at https://forums.adafruit.com/viewtopic.php?f=19&t=75497
  */
-void Sensor::saveCalibration()
+bool Sensor::saveCalibration()
 {
 	// put into config mode
 	bno->setMode (Adafruit_BNO055::OPERATION_MODE_CONFIG);
-	delay(25);
-
-	// request all bytes starting with the ACCEL
-	byte nbytes = (byte)sizeof(nv->BNO055cal);
-	Wire.beginTransmission((uint8_t)BNO055_I2CADDR);
-	Wire.write((uint8_t)(Adafruit_BNO055::ACCEL_OFFSET_X_LSB_ADDR));
-	Wire.endTransmission();
-	Wire.requestFrom((uint8_t)BNO055_I2CADDR, nbytes);
 
-	// wait for all 22 bytes to be available
-	while (Wire.available() < nbytes);
-
-	// copy to NV
-	Serial.println (F("Saving sensor values"));
-	for (uint8_t i = 0; i < nbytes; i++) {
-	    nv->BNO055cal[i] = Wire.read();
-	    Serial.println (nv->BNO055cal[i]);
-	}
+	// read all bytes starting with the ACCEL in one transfer
+	uint8_t cal[sizeof(nv->BNO055cal)];
+	bool ok = readRegs (Adafruit_BNO055::ACCEL_OFFSET_X_LSB_ADDR, cal, sizeof(cal));
 
 	// restore NDOF mode
 	bno->setMode (Adafruit_BNO055::OPERATION_MODE_NDOF);
-	delay(25);
+
+	if (!ok) {
+	    DEBUG_SERIAL.println (F("Sensor calibration read failed"));
+	    return (false);
+	}
 
 	// save in EEPROM
+	DEBUG_SERIAL.println (F("Saving sensor values"));
+	memcpy (nv->BNO055cal, cal, sizeof(cal));
 	nv->put();
+	return (true);
 }
 
 /* install previously stored calibration data from EEPROM if it looks valid.
+ * return whether it was installed.
+ * N.B. the offset and radius registers are contiguous so they all go in one auto-increment write.
  * Wanted to stick with stock Adafruit lib so pulled from
  * post by protonstorm at https://forums.adafruit.com/viewtopic.php?f=19&t=75497
  */
-void Sensor::installCalibration()
+bool Sensor::installCalibration()
 {
 	resetWatchdog();
+	if (!sensor_found)
+	    return (false);
 	byte nbytes = (byte)sizeof(nv->BNO055cal);
 
 	// read from EEPROM, qualify
@@ -162,24 +695,17 @@ void Sensor::installCalibration()
 		break;
 	}
 	if (i == nbytes)
-	    return;		// all zeros can't be valid
+	    return (false);	// all zeros can't be valid
 
 	// put into config mode
 	bno->setMode (Adafruit_BNO055::OPERATION_MODE_CONFIG);
-	delay(25);
 
 	// set from NV
-	// Serial.println (F("Restoring sensor values"));
-	for(uint8_t i = 0; i < nbytes; i++) {
-	    Wire.beginTransmission((uint8_t)BNO055_I2CADDR);
-	    Wire.write((Adafruit_BNO055::adafruit_bno055_reg_t)
-	    		((uint8_t)(Adafruit_BNO055::ACCEL_OFFSET_X_LSB_ADDR)+i));
-	    Wire.write(nv->BNO055cal[i]);
-	    // Serial.println (nv->BNO055cal[i]);
-	    Wire.endTransmission();
-	}
+	bool ok = writeRegs (Adafruit_BNO055::ACCEL_OFFSET_X_LSB_ADDR, nv->BNO055cal, nbytes);
 
 	// restore NDOF mode
 	bno->setMode (Adafruit_BNO055::OPERATION_MODE_NDOF);
-	delay(25);
+
+	DEBUG_SERIAL.println (ok ? F("Sensor calibration restored") : F("Sensor calibration restore failed"));
+	return (ok);
 }
@@ -8,7 +8,7 @@
 #include <WiFiClient.h>
 #include <Adafruit_Sensor.h>
 #include <Adafruit_BNO055.h>
-
+#include <circular_queue/circular_queue.h>
 
 #include "AutoSatTracker-ESP.h"
 #include "Circum.h"
@@ -22,17 +22,106 @@ class Sensor {
 	bool calibrated(uint8_t& sys, uint8_t& gyro, uint8_t& accel, uint8_t& mag);
 	enum {
 	    BNO055_I2CADDR = 0x28,	// I2C bus address of BNO055
+	    SAMPLE_REG0 = Adafruit_BNO055::BNO055_QUATERNION_DATA_W_LSB_ADDR,	// first register
+	    SAMPLE_NREGS = Adafruit_BNO055::BNO055_CALIB_STAT_ADDR - SAMPLE_REG0 + 1,	// 22
+	    HISTORY_N = 8,		// pointing samples kept for window statistics
+	    SUNCAL_MAX = 8,		// max sun alignment points
+	    SUNCAL_MINEL = 10,		// lowest sun el to use, degs, refraction is ignored
+	    SUNCAL_MINSEP = 10,		// min spread of sun points to solve, degs
+	    SUNCAL_ITERS = 10,		// boresight and heading refinements when solving
+	    TEMPLOG_MAX = 16,		// sun points kept for the temperature fit
+	    TEMPLOG_MINSPREAD = 5,	// min temperature range to fit, degs C
 	};
 
+	/* most recent readings, shared by all users so bus traffic does not depend on them.
+	 * all come from one burst of the contiguous quaternion .. calibration status registers.
+	 */
+	typedef struct {
+	    float az, el;		// pointing, degs
+	    float q[4];			// orientation w x y z, body to magnetic ENU
+	    float v[3];			// pointing before heading correction, magnetic ENU unit vector
+	    float lia[3];		// linear acceleration, m/s^2
+	    float grv[3];		// gravity, m/s^2
+	    int8_t temp;		// degs C
+	    uint8_t sys, gyro, accel, mag;	// calibration status, 0 .. 3
+	    uint32_t ms;		// millis() when read
+	} Sample;
+	Sample sample;
+	bool sampled;			// set once sample has been attempted
+	float bore[3];			// antenna boresight in sensor body frame, unit vector
+	float head;			// heading correction added to az, degs
+	void readSample();
+
+	/* recent pointing, oldest first, one entry per good sample
+	 */
+	typedef struct {
+	    float az, el;		// degs
+	    uint32_t ms;		// millis() when read
+	} Point;
+	circular_queue<Point> *history;
+
+	/* sun alignment. the board is fixed to the antenna however it is mounted, so the boresight
+	 * is one direction in the body frame whatever the orientation, and the magnetometer leaves
+	 * a heading error about Up. both are solved from the sensor orientation and the sun
+	 * direction recorded as the operator puts the antenna on the sun at different times.
+	 */
+	typedef struct {
+	    float q[4];			// orientation w x y z, body to magnetic ENU
+	    float s[3];			// sun, magnetic ENU unit vector
+	    int8_t temp;		// sensor temperature, degs C
+	} SunPoint;
+	SunPoint suncal[SUNCAL_MAX];
+	uint8_t nsuncal;		// number of suncal in use
+	bool align_ok;			// whether bore and head came from the sun, else the mount
+	float align_rms;		// residual over the points they were solved from, degs
+	bool sunAzEl (float &az, float &el);
+	bool addSunPoint();
+	bool solveSunAlign();
+	void clearSunAlign();
+
+	/* heading drift with temperature. every sun point is also logged here, oldest dropped when
+	 * full, and the heading error left after alignment is fit as a line in temperature.
+	 */
+	circular_queue<SunPoint> *templog;
+	float tempcomp[2];		// degs + degs/C * temperature, added to az
+	bool tempcomp_ok;		// whether tempcomp came from a fit, else 0
+	float tempcomp_rms;		// residual of the fit, degs
+	bool fitTempComp();
+	void clearTempComp();
+
+	/* I2C traffic
+	 */
+	uint32_t i2c_n;			// transactions since i2c_m0
+	uint32_t i2c_m0;		// millis() when i2c_n was reset
+	float i2c_rate;			// recent transactions per second
+	uint32_t i2c_errors;		// failed transactions
+	bool readRegs (uint8_t reg, uint8_t *buf, uint8_t n);
+	bool writeRegs (uint8_t reg, const uint8_t *buf, uint8_t n);
+
     public:
 
+	/* statistics of the pointing samples in a recent window.
+	 * az is unwrapped about the newest sample so a window spanning North is not split.
+	 */
+	typedef struct {
+	    float az_med, el_med;	// median, degs
+	    float az_mean, el_mean;	// mean, degs
+	    float az_var, el_var;	// sample variance, degs^2
+	    uint8_t n;			// number of samples used
+	} Window;
+
 	Sensor();
+	void update();
 	int8_t getTempC();
-	void getAzEl (float *azp, float *elp);
+	uint32_t getAzEl (float *azp, float *elp);
+	bool getWindow (Window &w, uint32_t since_ms);
+	static void boreENU (const imu::Quaternion &q, const float b[3], float v[3]);
+	static void enuAzEl (const float v[3], float &az, float &el);
+	static void azElENU (float az, float el, float v[3]);
 	void sendNewValues (WiFiClient client);
 	bool connected() { return sensor_found; };
-	void saveCalibration(void);
-	void installCalibration(void);
+	bool saveCalibration(void);
+	bool installCalibration(void);
 	bool overrideValue (char *name, char *value);
 
 };
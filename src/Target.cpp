@@ -10,17 +10,21 @@ Target::Target()
 	// init values
 	resetWatchdog();
 	az = el = range = rate = 0;
+	az_rate = el_rate = az_acc = el_acc = 0;
+	rates_ms = 0;
 	memset (TLE_L0, 0, sizeof(TLE_L0));
 	memset (TLE_L1, 0, sizeof(TLE_L1));
 	memset (TLE_L2, 0, sizeof(TLE_L2));
 	sat = new Satellite();
 	sun = new Sun();
+	obs = circum->observer();
 
 	// init flags
 	tle_ok = false;
 	tracking = false;
 	overridden = false;
 	set_ok = rise_ok = trans_ok = false;
+	repass = false;
 	nskypath = 0;
 }
 
@@ -33,9 +37,24 @@ void Target::track()
 	// update ephemerides
 	updateTopo();
 
-	// update gimbal if tracking
-	if (tracking)
-	    gimbal->moveToAzEl (az, el);
+	// once the pass rises or sets have Circum find the next events and sky path, so the gimbal
+	// gets the rest of this pass or the whole of the next whether or not a page is watching.
+	// wait REPASS_S so the search starts clear of the event it found, lest it find it again.
+	// N.B. transit jiggles back and forth too much to recompute after it
+	if (!repass && tle_ok && !overridden) {
+	    DateTime now (circum->now());
+	    now.add ((long)(-REPASS_S));
+	    if ((rise_ok && now.diff(rise_time) < 0) || (set_ok && now.diff(set_time) < 0)) {
+		repass = true;
+		circum->requestRecompute (Circum::RC_PASS);
+	    }
+	}
+
+	// update gimbal if tracking, telling it where the target is heading
+	if (tracking) {
+	    updateRates();
+	    gimbal->moveToAzEl (az, el, az_rate, el_rate, az_acc, el_acc);
+	}
 }
 
 /* update target info
@@ -46,8 +65,46 @@ void Target::updateTopo()
 	    DateTime now (circum->now());
 	    sat->predict (now);
 	    sun->predict (now);
-	    sat->topo (circum->observer(), el, az, range, rate);
+	    sat->topo (obs, el, az, range, rate);
+	}
+}
+
+/* update the az and el rates and accelerations from the ephemeris every RATES_MS.
+ * N.B. leaves sat at now
+ */
+void Target::updateRates()
+{
+	if (!tle_ok || overridden) {
+	    az_rate = el_rate = az_acc = el_acc = 0;
+	    return;
 	}
+
+	uint32_t ms = millis();
+	if (rates_ms != 0 && ms - rates_ms < RATES_MS)
+	    return;
+	rates_ms = ms;
+
+	// positions RATES_DT either side of now
+	DateTime now (circum->now());
+	DateTime t (now);
+	float az0, el0, az1, el1, r, rr;
+	t.add ((long)-RATES_DT);
+	sat->predict (t);
+	sat->topo (obs, el0, az0, r, rr);
+	t.add ((long)(2*RATES_DT));
+	sat->predict (t);
+	sat->topo (obs, el1, az1, r, rr);
+	sat->predict (now);
+	sat->topo (obs, el, az, range, rate);
+
+	// central differences, az taking the short way round
+	float daz0 = az - az0, daz1 = az1 - az;
+	daz0 -= daz0 > 180 ? 360 : (daz0 < -180 ? -360 : 0);
+	daz1 -= daz1 > 180 ? 360 : (daz1 < -180 ? -360 : 0);
+	az_rate = (daz0 + daz1)/(2*RATES_DT);
+	el_rate = (el1 - el0)/(2*RATES_DT);
+	az_acc = (daz1 - daz0)/(RATES_DT*RATES_DT);
+	el_acc = (el1 - 2*el + el0)/(RATES_DT*RATES_DT);
 }
 
 /* turn tracking on or off if it makes sense to do so
@@ -80,6 +137,28 @@ void Target::setTrackingState (bool want_on)
 	}
 }
 
+/* aim at the sun, as if the operator had overridden az and el, so the sensor can be aligned
+ */
+void Target::pointAtSun()
+{
+	DateTime now (circum->now());
+	sun->predict (now);
+	float s_az, s_el;
+	sun->topo (obs, s_el, s_az);
+	if (s_el < 0) {
+	    webpage->setUserMessage (F("Sun is down!"));
+	    return;
+	}
+
+	az = s_az;
+	el = s_el;
+	overridden = true;
+	tle_ok = false;
+	nskypath = 0;
+	gimbal->planPass (NULL, 0, false);
+	setTrackingState (true);
+}
+
 /* send latest values to web page.
  * N.B. names must match ids in web page
  */
@@ -87,25 +166,18 @@ void Target::sendNewValues (WiFiClient client)
 {
 
 	const __FlashStringHelper *zerostr = F("");
-
-	// update pass info just after main events
-	// N.B. transit jiggles back and forth too much to recompute after it
 	DateTime now (circum->now());
-	bool just_rose = rise_ok && now.diff(rise_time) < 0;
-	bool just_sat = set_ok && now.diff(set_time) < 0;
-	if (just_rose || just_sat) {
-	    updateTopo();
-	    findNextPass();
-	    computeSkyPath();
-	}
+
+	// predictions are flagged if our clock has drifted too far to be trusted
+	bool suspect = tle_ok && !overridden && circum->timeSuspect();
 
 	if (tle_ok || overridden) {
 	    client.print (F("T_Az="));
 	    client.print (az);
-	    displayAsWarning (client, overridden);
+	    displayAsWarning (client, overridden || suspect);
 	    client.print (F("T_El="));
 	    client.print (el);
-	    displayAsWarning (client, overridden);
+	    displayAsWarning (client, overridden || suspect);
 	}
 
 	if (tle_ok && !overridden) {
@@ -120,17 +192,22 @@ void Target::sendNewValues (WiFiClient client)
 	    else
 		client.println (F("Yes"));
 
-	    client.print (F("T_Range=")); client.println (range);
-	    client.print (F("T_RangeR=")); client.println (rate);
-	    client.print (F("T_VHFDoppler=")); client.println (-rate*144000/3e8); // want kHz
-	    client.print (F("T_UHFDoppler=")); client.println (-rate*440000/3e8); // want kHz
+	    client.print (F("T_Range=")); client.print (range);
+		displayAsWarning (client, suspect);
+	    client.print (F("T_RangeR=")); client.print (rate);
+		displayAsWarning (client, suspect);
+	    client.print (F("T_VHFDoppler=")); client.print (-rate*144000/3e8); // want kHz
+		displayAsWarning (client, suspect);
+	    client.print (F("T_UHFDoppler=")); client.print (-rate*440000/3e8); // want kHz
+		displayAsWarning (client, suspect);
 
 
 	    client.print (F("T_NextRise="));
 	    if (rise_ok) {
 		float dt = 24*now.diff(rise_time);
 		circum->printSexa (client, dt);
-		circum->printPL (client, (dt < 1.0/60.0) ? Circum::GOODNEWS : Circum::NORMAL);
+		circum->printPL (client, suspect ? Circum::BADNEWS
+					: (dt < 1.0/60.0) ? Circum::GOODNEWS : Circum::NORMAL);
 	    } else
 		client.println (F("??? !"));		// beware trigraphs
 
@@ -287,6 +364,7 @@ bool Target::overrideValue (char *name, char *value)
 	    overridden = true;
 	    tle_ok = false;
 	    nskypath = 0;
+	    gimbal->planPass (NULL, 0, false);
 	    return (true);
 	}
 	if (!strcmp (name, "T_El")) {
@@ -294,6 +372,7 @@ bool Target::overrideValue (char *name, char *value)
 	    overridden = true;
 	    tle_ok = false;
 	    nskypath = 0;
+	    gimbal->planPass (NULL, 0, false);
 	    return (true);
 	}
 	return (false);
@@ -309,14 +388,16 @@ void Target::setTLE (char *l1, char *l2, char *l3)
 	    strncpy (TLE_L0, l1, sizeof(TLE_L0)-1);
 	    strncpy (TLE_L1, l2, sizeof(TLE_L1)-1);
 	    strncpy (TLE_L2, l3, sizeof(TLE_L2)-1);
-	    Serial.println (TLE_L0);
-	    Serial.println (TLE_L1);
-	    Serial.println (TLE_L2);
+	    DEBUG_SERIAL.println (TLE_L0);
+	    DEBUG_SERIAL.println (TLE_L1);
+	    DEBUG_SERIAL.println (TLE_L2);
 	    overridden = false;
 	    tracking = false;
+	    set_ok = rise_ok = trans_ok = false;
+	    nskypath = 0;
+	    gimbal->planPass (NULL, 0, false);
 	    updateTopo();
-	    findNextPass();		// init for track()
-	    computeSkyPath();
+	    circum->requestRecompute (Circum::RC_PASS);	// init pass for track() soon
 	    webpage->setUserMessage (F("New TLE uploaded successfully for "), TLE_L0, '+');
 	} else {
 	    webpage->setUserMessage (F("Uploaded TLE is invalid!"));
@@ -342,15 +423,16 @@ void Target::findNextPass()
 
 	// search no more than two days ahead
 	set_ok = rise_ok = trans_ok = false;
+	repass = false;
 	while ((!set_ok || !rise_ok || !trans_ok) && circum->now().diff(t) < 2) {
 
 	    // find circumstances at time t
 	    float tel, taz, trange, trate;
 	    sat->predict (t);
-	    sat->topo (circum->observer(), tel, taz, trange, trate);
-	    // Serial.print (24*60*circum->now().diff(t)); Serial.print(" ");
-	    // Serial.print (tel, 6); Serial.print(" ");
-	    // Serial.print (rise_ok); Serial.print (trans_ok); Serial.println (set_ok);
+	    sat->topo (obs, tel, taz, trange, trate);
+	    // DEBUG_SERIAL.print (24*60*circum->now().diff(t)); DEBUG_SERIAL.print(" ");
+	    // DEBUG_SERIAL.print (tel, 6); DEBUG_SERIAL.print(" ");
+	    // DEBUG_SERIAL.print (rise_ok); DEBUG_SERIAL.print (trans_ok); DEBUG_SERIAL.println (set_ok);
 
 	    // check for a visible transit event
 	    // N.B. too flat to use FINE_DT
@@ -406,24 +488,21 @@ void Target::findNextPass()
 }
 
 /* compute sky path of current pass.
- * if up now just plot until set because rise_time will be for subsequent pass
+ * if up now, as told by the next set coming before the next rise, just plot until set because
+ * rise_time will be for subsequent pass. el is no guide just after set, when it is still
+ * near 0 but set_time already belongs to the next pass.
  */
 void Target::computeSkyPath()
 {
         if (!set_ok || !rise_ok)
             return;
 
+        bool up = rise_time.diff(set_time) <= 0;
         DateTime t;
-
-        if (el > -1)	// allow for a bit of rise/set round off
+        if (up)
             t = circum->now();
-        else if (rise_time.diff(set_time) > 0)
+        else
             t = rise_time;
-        else {
-            // rise or set is unknown or for different passes
-            nskypath = 0;
-            return;
-        }
 
 
         long secsup = (long)(t.diff(set_time)*24*3600);
@@ -432,9 +511,12 @@ void Target::computeSkyPath()
         for (nskypath = 0; nskypath < MAXSKYPATH; nskypath++) {
             float srange, srate;
             sat->predict (t);
-            sat->topo (circum->observer(), skypath[nskypath].el, skypath[nskypath].az, srange, srate);
+            sat->topo (obs, skypath[nskypath].el, skypath[nskypath].az, srange, srate);
             t.add (stepsecs);
         }
+
+        // let the gimbal plan how to follow it
+        gimbal->planPass (skypath, nskypath, up);
 }
 
 /* return whether the given line appears to be a valid TLE
@@ -21,8 +21,16 @@ class Target {
 	// target
 	float az, el;		// from TLE or op if overridden
 	float range, rate;
+	float az_rate, el_rate;	// degs/sec, 0 if overridden
+	float az_acc, el_acc;	// degs/sec^2, 0 if overridden
+	uint32_t rates_ms;	// millis() when rates were last found
+	enum {
+	    RATES_MS = 1000,	// ms between rate updates
+	    RATES_DT = 2,	// secs each side of now to find rates
+	};
 	Satellite *sat;
 	Sun *sun;
+	const Observer *obs;	// Circum's Observer, stable for our lifetime
 
 	// rise set transit state
 	DateTime rise_time;
@@ -31,6 +39,10 @@ class Target {
 	float rise_az, set_az;
 	float trans_az, trans_el;
 	bool set_ok, rise_ok, trans_ok;
+	bool repass;		// rise or set has passed and a new pass has been asked for
+	enum {
+	    REPASS_S = 2,	// secs after rise or set to ask, past the 1 sec the search finds it to
+	};
 
 	// current TLE lines
 	char TLE_L0[30];	// name is arbitrarily truncated to this length
@@ -42,11 +54,9 @@ class Target {
 	bool tracking;		// whether currently tracking
 	bool overridden;	// whether target az or el has been overridden
 
-	// skypath for displaying graph of a pass on an all-sky map
+	// skypath for displaying graph of a pass on an all-sky map, and planning the gimbal moves
 	enum {MAXSKYPATH = 20};
-	struct {
-	    float az, el;
-	} skypath[MAXSKYPATH];
+	SkyPoint skypath[MAXSKYPATH];
 	uint8_t nskypath;
 
 	// handy
@@ -58,10 +68,12 @@ class Target {
 	void track();
 	bool tleValidChecksum (const char *line);
 	void setTrackingState (bool on);
+	void pointAtSun(void);
         void sendNewValues (WiFiClient client);
         bool overrideValue (char *name, char *value);
 	void setTLE (char *l1, char *l2, char *l3);
 	void updateTopo(void);
+	void updateRates(void);
 	void findNextPass(void);
 	void computeSkyPath(void);
 
@@ -0,0 +1,210 @@
+/* parse u-blox UBX binary NAV-PVT frames behind the same interface Circum uses from TinyGPS.
+ */
+
+#include "UBX.h"
+
+#define	UBX_SYNC1	0xB5			// first frame sync byte
+#define	UBX_SYNC2	0x62			// second frame sync byte
+#define	UBX_MAXLEN	1024			// longer payload means we lost sync
+
+/* constructor
+ */
+UBX::UBX()
+{
+	state = SYNC1;
+	lat_u = lng_u = GPS_INVALID_ANGLE;
+	alt_cm = GPS_INVALID_ALTITUDE;
+	date = GPS_INVALID_DATE;
+	time = GPS_INVALID_TIME;
+	time_fix = pos_fix = GPS_INVALID_FIX_TIME;
+	nsv = GPS_INVALID_SATELLITES;
+	pdop_100 = GPS_INVALID_HDOP;
+	mode = GPS_INVALID_FIX_MODE;
+	clearAck();
+}
+
+/* process one byte from the receiver.
+ * return true when it completes a NAV-PVT frame with a good checksum.
+ */
+bool UBX::encode (char c)
+{
+	uint8_t b = (uint8_t)c;
+
+	// checksum covers class through payload
+	if (state >= CLASS && state <= PAYLOAD) {
+	    ck_a += b;
+	    ck_b += ck_a;
+	}
+
+	switch (state) {
+	case SYNC1:
+	    if (b == UBX_SYNC1)
+		state = SYNC2;
+	    break;
+	case SYNC2:
+	    // allow for B5 B5 62
+	    state = b == UBX_SYNC2 ? CLASS : (b == UBX_SYNC1 ? SYNC2 : SYNC1);
+	    ck_a = ck_b = 0;
+	    break;
+	case CLASS:
+	    cls = b;
+	    state = ID;
+	    break;
+	case ID:
+	    id = b;
+	    state = LEN1;
+	    break;
+	case LEN1:
+	    len = b;
+	    state = LEN2;
+	    break;
+	case LEN2:
+	    len |= (uint16_t)b << 8;
+	    n = 0;
+	    if (len > UBX_MAXLEN)
+		state = SYNC1;			// can not be real, resync
+	    else
+		state = len > 0 ? PAYLOAD : CK_A;
+	    break;
+	case PAYLOAD:
+	    // keep only what fits, longer frames are not ours but still need their checksum skipped
+	    if (n < sizeof(payload.raw))
+		payload.raw[n] = b;
+	    if (++n == len)
+		state = CK_A;
+	    break;
+	case CK_A:
+	    state = b == ck_a ? CK_B : SYNC1;
+	    break;
+	case CK_B:
+	    state = SYNC1;
+	    if (b == ck_b)
+		return (frameComplete());
+	    break;
+	}
+
+	return (false);
+}
+
+/* a frame has arrived with a good checksum, use it if it is one we know.
+ * return true if it was a NAV-PVT solution.
+ */
+bool UBX::frameComplete()
+{
+	static_assert (sizeof(NavPVT) == 92, "NAV-PVT payload must match the receiver's layout");
+
+	if (cls == CLS_ACK && len == 2) {
+	    ack_cls = payload.raw[0];
+	    ack_id = payload.raw[1];
+	    ack_flag = id == ID_ACK_ACK;
+	    return (false);
+	}
+
+	if (cls != CLS_NAV || id != ID_NAV_PVT || len != sizeof(NavPVT))
+	    return (false);
+
+	const NavPVT &p = payload.pvt;
+	uint32_t ms = millis();
+
+	// date and time once both are known to be right
+	if ((p.valid & 3) == 3) {
+	    uint8_t cs = p.nano > 0 ? p.nano/10000000L : 0;
+	    date = 10000UL*p.day + 100UL*p.month + p.year%100;
+	    time = 1000000UL*p.hour + 10000UL*p.min + 100UL*p.sec + cs;
+	    time_fix = ms;
+	}
+
+	// position only when the receiver says the fix is good
+	mode = p.fixType == 2 ? 2 : (p.fixType == 3 || p.fixType == 4 ? 3 : 1);
+	nsv = p.numSV;
+	pdop_100 = p.pDOP;
+	if ((p.flags & 1) && mode >= 2) {
+	    lat_u = (p.lat + (p.lat < 0 ? -5 : 5))/10;
+	    lng_u = (p.lon + (p.lon < 0 ? -5 : 5))/10;
+	    alt_cm = p.hMSL/10;
+	    pos_fix = ms;
+	}
+
+	return (true);
+}
+
+/* lat/long in millionths of a degree and age of fix in milliseconds
+ */
+void UBX::get_position (long *latitude, long *longitude, unsigned long *fix_age)
+{
+	if (latitude) *latitude = lat_u;
+	if (longitude) *longitude = lng_u;
+	if (fix_age) *fix_age = pos_fix == GPS_INVALID_FIX_TIME ? GPS_INVALID_AGE : millis() - pos_fix;
+}
+
+/* date as ddmmyy, time as hhmmsscc, and age in milliseconds
+ */
+void UBX::get_datetime (unsigned long *d, unsigned long *t, unsigned long *age)
+{
+	if (d) *d = date;
+	if (t) *t = time;
+	if (age) *age = time_fix == GPS_INVALID_FIX_TIME ? GPS_INVALID_AGE : millis() - time_fix;
+}
+
+/* date and time broken out, as TinyGPS
+ */
+void UBX::crack_datetime (int *year, byte *month, byte *day, byte *hour, byte *minute,
+byte *second, byte *hundredths, unsigned long *age)
+{
+	unsigned long d, t;
+	get_datetime (&d, &t, age);
+	if (year) {
+	    *year = d % 100;
+	    *year += *year > 80 ? 1900 : 2000;
+	}
+	if (month) *month = (d / 100) % 100;
+	if (day) *day = d / 10000;
+	if (hour) *hour = t / 1000000;
+	if (minute) *minute = (t / 10000) % 100;
+	if (second) *second = (t / 100) % 100;
+	if (hundredths) *hundredths = t % 100;
+}
+
+/* build a complete frame for the given message in buf, adding sync, length and checksum.
+ * return its length, or 0 if it does not fit in bufsize.
+ */
+uint8_t UBX::frame (uint8_t cls, uint8_t id, const uint8_t *body, uint16_t len,
+uint8_t *buf, uint8_t bufsize)
+{
+	if (len + 8 > bufsize)
+	    return (0);
+
+	buf[0] = UBX_SYNC1;
+	buf[1] = UBX_SYNC2;
+	buf[2] = cls;
+	buf[3] = id;
+	buf[4] = len & 0xff;
+	buf[5] = len >> 8;
+	memcpy (&buf[6], body, len);
+
+	uint8_t a = 0, b = 0;
+	for (uint16_t i = 2; i < len + 6; i++) {
+	    a += buf[i];
+	    b += a;
+	}
+	buf[len+6] = a;
+	buf[len+7] = b;
+
+	return (len + 8);
+}
+
+/* forget any previous ACK or NAK, call before sending a message that will be acknowledged.
+ */
+void UBX::clearAck()
+{
+	ack_flag = -1;
+}
+
+/* return 1 if the given message has been ACKed, 0 if NAKed, else -1.
+ */
+int UBX::acked (uint8_t cls, uint8_t id)
+{
+	if (ack_flag < 0 || ack_cls != cls || ack_id != id)
+	    return (-1);
+	return (ack_flag);
+}
@@ -0,0 +1,118 @@
+/* parse u-blox UBX binary NAV-PVT frames behind the same interface Circum uses from TinyGPS.
+ * one 100 byte frame carries everything RMC, GGA, GSA and ZDA do between them, and is decoded by
+ * overlaying its payload rather than by converting ASCII terms.
+ */
+
+#ifndef _UBX_H
+#define _UBX_H
+
+#include <Arduino.h>
+
+class UBX {
+
+    public:
+
+	// same sentinels as TinyGPS so callers need not care which parser they have
+	enum {
+	    GPS_INVALID_AGE = 0xFFFFFFFF,	GPS_INVALID_ANGLE = 999999999,
+	    GPS_INVALID_ALTITUDE = 999999999,	GPS_INVALID_DATE = 0,
+	    GPS_INVALID_TIME = 0xFFFFFFFF,	GPS_INVALID_FIX_TIME = 0xFFFFFFFF,
+	    GPS_INVALID_SATELLITES = 0xFF,	GPS_INVALID_HDOP = 0xFFFFFFFF,
+	    GPS_INVALID_FIX_MODE = 0
+	};
+
+	// message classes and ids we use
+	enum {
+	    CLS_NAV = 0x01, ID_NAV_PVT = 0x07,
+	    CLS_ACK = 0x05, ID_ACK_NAK = 0x00, ID_ACK_ACK = 0x01,
+	    CLS_CFG = 0x06, ID_CFG_MSG = 0x01, ID_CFG_RATE = 0x08,
+	    CLS_NMEA = 0xF0,
+	};
+
+	UBX();
+	bool encode (char c);
+
+	// TinyGPS compatible accessors
+	void get_position (long *latitude, long *longitude, unsigned long *fix_age = 0);
+	void get_datetime (unsigned long *date, unsigned long *time, unsigned long *age = 0);
+	void crack_datetime (int *year, byte *month, byte *day, byte *hour, byte *minute,
+		byte *second, byte *hundredths = 0, unsigned long *fix_age = 0);
+	long altitude() { return (alt_cm); }
+	unsigned short satellites() { return (nsv); }
+	unsigned long hdop() { return (pdop_100); }	// NAV-PVT has no HDOP, PDOP bounds it
+	byte fix_mode() { return (mode); }
+	unsigned long pdop() { return (pdop_100); }
+	unsigned long vdop() { return (GPS_INVALID_HDOP); }
+	byte satellites_in_view() { return (nsv == GPS_INVALID_SATELLITES ? 0 : nsv); }
+	bool satellite (byte i, byte *prn, byte *snr) { return (false); }
+	void get_zda_datetime (unsigned long *date, unsigned long *time, unsigned long *age = 0)
+	    { get_datetime (date, time, age); }
+
+	// configuration support
+	static uint8_t frame (uint8_t cls, uint8_t id, const uint8_t *body, uint16_t len,
+		uint8_t *buf, uint8_t bufsize);
+	void clearAck();
+	int acked (uint8_t cls, uint8_t id);
+
+    private:
+
+	/* NAV-PVT payload as sent, little-endian and packed so it can be received in place
+	 */
+	typedef struct __attribute__((packed)) {
+	    uint32_t iTOW;			// GPS time of week, ms
+	    uint16_t year;
+	    uint8_t month, day, hour, min, sec;
+	    uint8_t valid;			// 1 date, 2 time, 4 fully resolved
+	    uint32_t tAcc;			// time accuracy, ns
+	    int32_t nano;			// fraction of second, ns
+	    uint8_t fixType;			// 0 none, 2 2D, 3 3D, 4 GNSS+DR, 5 time only
+	    uint8_t flags;			// 1 gnssFixOK
+	    uint8_t flags2;
+	    uint8_t numSV;
+	    int32_t lon, lat;			// 1e-7 degs
+	    int32_t height;			// above ellipsoid, mm
+	    int32_t hMSL;			// above mean sea level, mm
+	    uint32_t hAcc, vAcc;		// mm
+	    int32_t velN, velE, velD;		// mm/s
+	    int32_t gSpeed;			// mm/s
+	    int32_t headMot;			// 1e-5 degs
+	    uint32_t sAcc;			// mm/s
+	    uint32_t headAcc;			// 1e-5 degs
+	    uint16_t pDOP;			// 0.01
+	    uint8_t flags3;
+	    uint8_t reserved[5];
+	    int32_t headVeh;			// 1e-5 degs
+	    int16_t magDec;			// 1e-2 degs
+	    uint16_t magAcc;			// 1e-2 degs
+	} NavPVT;
+
+	// frame parsing state
+	typedef enum {
+	    SYNC1, SYNC2, CLASS, ID, LEN1, LEN2, PAYLOAD, CK_A, CK_B
+	} FrameState;
+	FrameState state;
+	uint8_t cls, id;			// of frame being received
+	uint16_t len, n;			// its payload length, and bytes so far
+	uint8_t ck_a, ck_b;			// running Fletcher checksum
+	union {
+	    NavPVT pvt;
+	    uint8_t raw[sizeof(NavPVT)];
+	} payload;
+	bool frameComplete();
+
+	// most recent good solution, in TinyGPS units
+	long lat_u, lng_u;			// millionths of a degree
+	long alt_cm;				// cm above MSL
+	unsigned long date;			// ddmmyy
+	unsigned long time;			// hhmmsscc
+	unsigned long time_fix, pos_fix;	// millis() when each was last good
+	unsigned short nsv;			// satellites used
+	unsigned long pdop_100;			// PDOP, 100ths
+	byte mode;				// 1 none, 2 2D, 3 3D
+
+	// most recent ACK or NAK
+	uint8_t ack_cls, ack_id;		// message acknowledged
+	int ack_flag;				// 1 ACK, 0 NAK, -1 none yet
+};
+
+#endif // _UBX_H
@@ -18,10 +18,10 @@ Webpage::Webpage()
 
 	// create server
 	resetWatchdog();
-	Serial.println ("Creating ethernet server");
+	DEBUG_SERIAL.println ("Creating ethernet server");
 	httpServer = new WiFiServer(80);				// http
 	httpServer->begin();
-	Serial.println (WiFi.localIP());
+	DEBUG_SERIAL.println (WiFi.localIP());
 
 	// init user message mechanism
 	user_message_F = F("Hello+");					// page welcome message
@@ -53,7 +53,7 @@ bool Webpage::connectWiFi()
 	while (WiFi.status() != WL_CONNECTED) {
 	    resetWatchdog();
 	    if (millis() - t0 > timeout) {
-		Serial.println (F("connect failed, starting as AP"));
+		DEBUG_SERIAL.println (F("connect failed, starting as AP"));
 		return (false);
 	    }
 	    delay(100);
@@ -88,7 +88,7 @@ void Webpage::checkEthernet()
 	if (!client)
 	    return;
 
-	// Serial.println ("client connected");
+	// DEBUG_SERIAL.println ("client connected");
 	uint32_t to = millis();		// init timeout
 	char firstline[128];		// first line
 	unsigned fll = 0;		// firstline length
@@ -111,7 +111,7 @@ void Webpage::checkEthernet()
 	    prevc = c;
 	}
 	if (c == 0) {
-	    // Serial.println ("closing client");
+	    // DEBUG_SERIAL.println ("closing client");
 	    client.stop();
 	    return;
 	}
@@ -125,7 +125,7 @@ void Webpage::checkEthernet()
 
 	// what we do next depends on first line
 	resetWatchdog();
-	// Serial.println (firstline);
+	// DEBUG_SERIAL.println (firstline);
 	if (strstr (firstline, "GET / ")) {
 	    sendMainPage (client);
 	} else if (strstr (firstline, "GET /getvalues.txt ")) {
@@ -147,7 +147,7 @@ void Webpage::checkEthernet()
 	}
 
 	// finished
-	// Serial.println ("closing client");
+	// DEBUG_SERIAL.println ("closing client");
 	client.stop();
 }
 
@@ -187,7 +187,7 @@ void Webpage::startTLEFetch (char *query_text)
 	}
 
 	// send query to retrieve the file containing TLEs
-	// Serial.print(sat); Serial.print(F("@")); Serial.println (url);
+	// DEBUG_SERIAL.print(sat); DEBUG_SERIAL.print(F("@")); DEBUG_SERIAL.println (url);
 	tlef.remote->print (F("GET /"));
 	tlef.remote->print (path);
 	tlef.remote->print (F(" HTTP/1.0\r\n"));
@@ -270,7 +270,7 @@ void Webpage::resumeTLEFetch ()
 		    *bp++ = c;				// add to buf iif room, including EOS
 	    } else {
 		// static long n;
-		// Serial.println (n++);
+		// DEBUG_SERIAL.println (n++);
 	    }
 	}
 
@@ -317,7 +317,7 @@ char Webpage::readNextClientChar (WiFiClient client, uint32_t *to)
 	resetWatchdog();
 	while (client.connected()) {
 	    if (millis() > *to + timeout) {
-		Serial.println ("client timed out");
+		DEBUG_SERIAL.println ("client timed out");
 		return (0);
 	    }
 	    if (!client.available())
@@ -326,10 +326,10 @@ char Webpage::readNextClientChar (WiFiClient client, uint32_t *to)
 	    *to = millis();
 	    if (c == '\r')
 		continue;
-	    // Serial.write(c);
+	    // DEBUG_SERIAL.write(c);
 	    return (c);
 	}
-	// Serial.println ("client disconnected");
+	// DEBUG_SERIAL.println ("client disconnected");
 	return (0);
 }
 
@@ -361,7 +361,7 @@ void Webpage::overrideValue (WiFiClient client)
 	*valu++ = '\0';	// replace = with 0 then valu starts at next char
 	// now buf is NAME and valu is VALUE
 
-	Serial.print (F("Override: ")); Serial.print (buf); Serial.print("="); Serial.println (valu);
+	DEBUG_SERIAL.print (F("Override: ")); DEBUG_SERIAL.print (buf); DEBUG_SERIAL.print("="); DEBUG_SERIAL.println (valu);
 
 	if (strcmp (buf, "T_TLE") == 0) {
 
@@ -417,7 +417,8 @@ void Webpage::overrideValue (WiFiClient client)
 	    if (!circum->overrideValue (buf, valu)
 			&& !gimbal->overrideValue (buf, valu)
 			&& !target->overrideValue (buf, valu)
-			&& !sensor->overrideValue (buf, valu))
+			&& !sensor->overrideValue (buf, valu)
+			&& !control->overrideValue (buf, valu))
 		setUserMessage (F("Bug: unknown override -- see Serial Monitor!"));
 
 	}
@@ -465,6 +466,7 @@ void Webpage::sendNewValues (WiFiClient client)
 	gimbal->sendNewValues (client);
 	sensor->sendNewValues (client);
 	target->sendNewValues (client);
+	control->sendNewValues (client);
 
 }
 
@@ -1166,7 +1168,7 @@ void Webpage::sendMainPage (WiFiClient client)
             "                            <button id='IP-set' onclick='onIP(0,event)'>Change</button \r\n"
             "                        </td> \r\n"
             "                        <td width='50%' style='border:none' > \r\n"
-            "                            <label id='title-label' title='Version 2018072919' >Autonomous Satellite Tracker</label> \r\n"
+            "                            <label id='title-label' title='Version 2026101911' >Autonomous Satellite Tracker</label> \r\n"
             "                            <br> \r\n"
             "                            <label id='title-attrib' > by \r\n"
             "                                <a target='_blank' href='http://www.clearskyinstitute.com/ham'>WB&Oslash;OEW</a> \r\n"
@@ -1345,7 +1347,7 @@ void Webpage::sendMainPage (WiFiClient client)
             " \r\n"
             " \r\n"
             "        <tr class='minor-section even-row' > \r\n"
-            "            <th rowspan='4' class='group-head' > \r\n"
+            "            <th rowspan='7' class='group-head' > \r\n"
             "                    Spatial sensor \r\n"
             "                <br> \r\n"
             "                <label id='SS_Status'></label> \r\n"
@@ -1382,20 +1384,52 @@ void Webpage::sendMainPage (WiFiClient client)
             "            <td></td> \r\n"
             "        </tr> \r\n"
             "        <tr class='odd-row' > \r\n"
-            "            <td class='datum-label' ></td> \r\n"
-            "            <td id='SS_XXX' class='datum' > </td> \r\n"
+            "            <td class='datum-label' > Sample age, ms </td> \r\n"
+            "            <td id='SS_Age' class='datum' > </td> \r\n"
             "            <td></td> \r\n"
             " \r\n"
             "            <td class='datum-label' > Accelerometer status </td> \r\n"
             "            <td id='SS_AStatus' class='datum' > </td> \r\n"
             "            <td></td> \r\n"
             "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > I2C transactions per second </td> \r\n"
+            "            <td id='SS_I2CRate' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > I2C errors </td> \r\n"
+            "            <td id='SS_I2CErr' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Sun: Point, Add, Solve, Clear, TempFit, TempClear </td> \r\n"
+            "            <td id='SS_SunCal' class='datum' > </td> \r\n"
+            "            <td> \r\n"
+            "                <input id='SS_SunCal_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
+            "                </input> \r\n"
+            "            </td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Sun Az El, degrees </td> \r\n"
+        ));
+        client.print (F(
+            "            <td id='SS_SunAzEl' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Heading temperature comp, degs + degs/C </td> \r\n"
+            "            <td id='SS_TempComp' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Sun points logged for temperature </td> \r\n"
+            "            <td id='SS_TempLog' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
             " \r\n"
             " \r\n"
             " \r\n"
             " \r\n"
             "        <tr class='minor-section even-row' > \r\n"
-            "            <th rowspan='4' class='group-head' > \r\n"
+            "            <th rowspan='13' class='group-head' > \r\n"
             "                    GPS \r\n"
             "                <br> \r\n"
             "                <label id='GPS_Status'></label> \r\n"
@@ -1414,8 +1448,6 @@ void Webpage::sendMainPage (WiFiClient client)
             "            <td id='GPS_Alt' class='datum' > </td> \r\n"
             "            <td> \r\n"
             "                <input id='GPS_Alt_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
-        ));
-        client.print (F(
             "                </input> \r\n"
             "            </td> \r\n"
             "        </tr> \r\n"
@@ -1438,6 +1470,8 @@ void Webpage::sendMainPage (WiFiClient client)
             "                <input id='GPS_Lat_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
             "                </input> \r\n"
             "            </td> \r\n"
+        ));
+        client.print (F(
             " \r\n"
             "            <td class='datum-label' > HDOP, ~1 .. 20 </td> \r\n"
             "            <td id='GPS_HDOP' class='datum' > </td> \r\n"
@@ -1455,12 +1489,95 @@ void Webpage::sendMainPage (WiFiClient client)
             "            <td id='GPS_NSat' class='datum' > </td> \r\n"
             "            <td></td> \r\n"
             "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Pass recomputes saved </td> \r\n"
+            "            <td id='GPS_RCSaved' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > PPS offset, &micro;s </td> \r\n"
+            "            <td id='GPS_ClkOff' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Clock drift, ppm </td> \r\n"
+            "            <td id='GPS_ClkDrift' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > PPS jitter, &micro;s </td> \r\n"
+            "            <td id='GPS_ClkJit' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Time uncertainty, s </td> \r\n"
+            "            <td id='GPS_TimeUnc' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Learned drift, ppm </td> \r\n"
+            "            <td id='GPS_HoldDrift' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Longest GPS check, &micro;s </td> \r\n"
+            "            <td id='GPS_MaxUs' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Bytes parsed per second </td> \r\n"
+            "            <td id='GPS_Bps' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Serial buffer overruns </td> \r\n"
+            "            <td id='GPS_Drops' class='datum' > </td> \r\n"
+        ));
+        client.print (F(
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Sentence handling, &micro;s </td> \r\n"
+            "            <td id='GPS_ParseUs' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Fix mode </td> \r\n"
+            "            <td id='GPS_FixMode' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Satellites in view </td> \r\n"
+            "            <td id='GPS_InView' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > PDOP </td> \r\n"
+            "            <td id='GPS_PDOP' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > VDOP </td> \r\n"
+            "            <td id='GPS_VDOP' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > SNR best / mean, dB-Hz </td> \r\n"
+            "            <td id='GPS_SNR' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > ZDA time </td> \r\n"
+            "            <td id='GPS_ZDA' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Time source </td> \r\n"
+            "            <td id='GPS_TimeSrc' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > NTP round trip, ms </td> \r\n"
+            "            <td id='GPS_NTPRtt' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
             " \r\n"
             " \r\n"
             " \r\n"
             "        <!-- N.B. beware that some ID's are used in a match in onOvd(event) --> \r\n"
             "        <tr class='minor-section even-row ' > \r\n"
-            "            <th rowspan='3' class='group-head' > \r\n"
+            "            <th rowspan='8' class='group-head' > \r\n"
             "                    Gimbal \r\n"
             "                <br> \r\n"
             "                <label id='G_Status'></label> \r\n"
@@ -1512,6 +1629,105 @@ void Webpage::sendMainPage (WiFiClient client)
             "                </input> \r\n"
             "            </td> \r\n"
             "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Time to settle after move, ms </td> \r\n"
+            "            <td id='G_SettleMs' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Estimate std dev Az El, degrees </td> \r\n"
+            "            <td id='G_EstSD' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Estimated Azimuth, degrees E of N </td> \r\n"
+            "            <td id='G_EstAz' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Estimated Elevation, degrees Up </td> \r\n"
+            "            <td id='G_EstEl' class='datum' > </td> \r\n"
+        ));
+        client.print (F(
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Lead ahead of target, ms </td> \r\n"
+            "            <td id='G_LeadMs' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > RMS pointing error, degrees </td> \r\n"
+            "            <td id='G_RMSErr' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Max servo slew, &micro;s/sec </td> \r\n"
+            "            <td id='G_MaxVel' class='datum' > </td> \r\n"
+            "            <td> \r\n"
+            "                <input id='G_MaxVel_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
+            "                </input> \r\n"
+            "            </td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Max servo acceleration, &micro;s/sec&sup2; </td> \r\n"
+            "            <td id='G_MaxAcc' class='datum' > </td> \r\n"
+            "            <td> \r\n"
+            "                <input id='G_MaxAcc_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
+            "                </input> \r\n"
+            "            </td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Pass plan </td> \r\n"
+            "            <td id='G_Plan' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Over the top </td> \r\n"
+            "            <td id='G_Flipped' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            " \r\n"
+            " \r\n"
+            "        <tr class='minor-section even-row ' > \r\n"
+            "            <th rowspan='3' class='group-head' > \r\n"
+            "                    Control loop \r\n"
+            "                <br> \r\n"
+            "                <label id='C_Status'></label> \r\n"
+            "            </th> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Sense period, ms </td> \r\n"
+            "            <td id='C_SenseMs' class='datum' > </td> \r\n"
+            "            <td> \r\n"
+            "                <input id='C_SenseMs_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
+            "                </input> \r\n"
+            "            </td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Sense lateness mean/max, ms </td> \r\n"
+            "            <td id='C_SenseLate' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='odd-row' > \r\n"
+            "            <td class='datum-label' > Estimate period, ms </td> \r\n"
+            "            <td id='C_EstMs' class='datum' > </td> \r\n"
+        ));
+        client.print (F(
+            "            <td> \r\n"
+            "                <input id='C_EstMs_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
+            "                </input> \r\n"
+            "            </td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Estimate lateness mean/max, ms </td> \r\n"
+            "            <td id='C_EstLate' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
+            "        <tr class='even-row' > \r\n"
+            "            <td class='datum-label' > Actuate period, ms </td> \r\n"
+            "            <td id='C_ActMs' class='datum' > </td> \r\n"
+            "            <td> \r\n"
+            "                <input id='C_ActMs_Ovd' type='text' onkeypress='onOvd(event)' class='override' > \r\n"
+            "                </input> \r\n"
+            "            </td> \r\n"
+            " \r\n"
+            "            <td class='datum-label' > Actuate lateness mean/max, ms </td> \r\n"
+            "            <td id='C_ActLate' class='datum' > </td> \r\n"
+            "            <td></td> \r\n"
+            "        </tr> \r\n"
             " \r\n"
             "    </table> \r\n"
             " \r\n"
@@ -1563,7 +1779,7 @@ void Webpage::sendEmptyResponse (WiFiClient client)
  */
 void Webpage::send404Page (WiFiClient client)
 {
-	Serial.println ("Sending 404");
+	DEBUG_SERIAL.println ("Sending 404");
 	client.print (F(
 	    "HTTP/1.0 404 Not Found \r\n"
 	    "Content-Type: text/html \r\n"
@@ -1582,7 +1798,7 @@ void Webpage::send404Page (WiFiClient client)
 void Webpage::reboot()
 {
 	resetWatchdog();
-	Serial.println("rebooting");
+	DEBUG_SERIAL.println("rebooting");
 	delay(5000);
 	ESP.restart();
 }
@@ -13,6 +13,7 @@
 #include "Circum.h"
 #include "Gimbal.h"
 #include "Target.h"
+#include "Control.h"
 #include "NV.h"
 
 // persistent state info to fetch a TLE from a remote web site incrementally
@@ -0,0 +1,118 @@
+/* a simulated BNO055 for the Sensor tests: answers the sample register burst with the
+ * quaternion that turns the sensor body so the antenna points at a given az and el.
+ */
+
+#ifndef _BNOSIM_H
+#define _BNOSIM_H
+
+#include <Wire.h>
+#include <math.h>
+
+#include "host.h"
+
+#define	SIM_QREG	0x20			// BNO055_QUATERNION_DATA_W_LSB_ADDR
+#define	SIM_NREGS	22			// quaternion .. calibration status
+
+class BNOSim {
+
+    public:
+
+	double q[4];			// w x y z, body to East North Up
+	int8_t temp;			// degs C
+
+	BNOSim() : temp(25) { q[0] = 1; q[1] = q[2] = q[3] = 0; }
+
+	/* set q from the body to ENU rotation matrix R
+	 */
+	void setMatrix (const double R[3][3]) {
+	    double tr = R[0][0] + R[1][1] + R[2][2];
+	    if (tr > 0) {
+		double s = 2*sqrt (tr + 1);
+		q[0] = s/4;
+		q[1] = (R[2][1] - R[1][2])/s;
+		q[2] = (R[0][2] - R[2][0])/s;
+		q[3] = (R[1][0] - R[0][1])/s;
+	    } else if (R[0][0] > R[1][1] && R[0][0] > R[2][2]) {
+		double s = 2*sqrt (1 + R[0][0] - R[1][1] - R[2][2]);
+		q[0] = (R[2][1] - R[1][2])/s;
+		q[1] = s/4;
+		q[2] = (R[0][1] + R[1][0])/s;
+		q[3] = (R[0][2] + R[2][0])/s;
+	    } else if (R[1][1] > R[2][2]) {
+		double s = 2*sqrt (1 + R[1][1] - R[0][0] - R[2][2]);
+		q[0] = (R[0][2] - R[2][0])/s;
+		q[1] = (R[0][1] + R[1][0])/s;
+		q[2] = s/4;
+		q[3] = (R[1][2] + R[2][1])/s;
+	    } else {
+		double s = 2*sqrt (1 + R[2][2] - R[0][0] - R[1][1]);
+		q[0] = (R[1][0] - R[0][1])/s;
+		q[1] = (R[0][2] + R[2][0])/s;
+		q[2] = (R[1][2] + R[2][1])/s;
+		q[3] = s/4;
+	    }
+	}
+
+	/* point the boresight at az el with the board level about it, then roll it by roll degs
+	 * about the boresight. the boresight is body -Y unless given as a unit body vector bore.
+	 */
+	void point (double az, double el, double roll = 0, const double *bore = NULL) {
+	    double a = az*M_PI/180, e = el*M_PI/180, r = roll*M_PI/180;
+	    // body -Y along the boresight, body Z up in the vertical plane through it, X completes
+	    double b[3] = {cos(e)*sin(a), cos(e)*cos(a), sin(e)};
+	    double u[3] = {-sin(e)*sin(a), -sin(e)*cos(a), cos(e)};
+	    double x[3] = {u[1]*b[2] - u[2]*b[1], u[2]*b[0] - u[0]*b[2], u[0]*b[1] - u[1]*b[0]};
+	    // roll x and u about b
+	    double x2[3], u2[3];
+	    for (int i = 0; i < 3; i++) {
+		x2[i] = cos(r)*x[i] + sin(r)*u[i];
+		u2[i] = cos(r)*u[i] - sin(r)*x[i];
+	    }
+	    // columns are the body axes in ENU: X, Y = -b, Z
+	    double R[3][3];
+	    for (int i = 0; i < 3; i++) {
+		R[i][0] = x2[i];
+		R[i][1] = -b[i];
+		R[i][2] = u2[i];
+	    }
+
+	    // then turn the body so bore goes where -Y went: R C', C the least turn from -Y to bore
+	    if (bore) {
+		double v[3] = {-bore[2], 0, bore[0]};		// -Y x bore
+		double c = -bore[1];
+		double V[3][3] = {{0, -v[2], v[1]}, {v[2], 0, -v[0]}, {-v[1], v[0], 0}};
+		double C[3][3], RC[3][3];
+		for (int i = 0; i < 3; i++)
+		    for (int j = 0; j < 3; j++) {
+			double vv = 0;
+			for (int k = 0; k < 3; k++)
+			    vv += V[i][k]*V[k][j];
+			C[i][j] = (i == j) + V[i][j] + vv/(1 + c);
+		    }
+		for (int i = 0; i < 3; i++)
+		    for (int j = 0; j < 3; j++)
+			RC[i][j] = R[i][0]*C[j][0] + R[i][1]*C[j][1] + R[i][2]*C[j][2];
+		setMatrix (RC);
+	    } else
+		setMatrix (R);
+	}
+
+	/* answer the Sensor's register reads from now on
+	 */
+	void attach() {
+	    wire_read = [this](uint8_t, uint8_t reg, uint8_t *buf, uint8_t n) {
+		if (reg != SIM_QREG || n != SIM_NREGS)
+		    return (true);
+		for (int i = 0; i < 4; i++) {
+		    int16_t v = (int16_t)lround (q[i]*(1 << 14));
+		    buf[2*i] = v & 0xff;
+		    buf[2*i+1] = (v >> 8) & 0xff;
+		}
+		buf[20] = (uint8_t)temp;
+		buf[21] = 0xff;			// all calibrated
+		return (true);
+	    };
+	}
+};
+
+#endif // _BNOSIM_H
@@ -0,0 +1,74 @@
+/* host versions of the core functions and objects the stubs declare.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <EEPROM.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include <SoftwareSerial.h>
+
+#include "host.h"
+
+uint64_t host_us;
+static void (*host_isr[32])(void);
+
+unsigned long millis() { return ((unsigned long)(host_us/1000)); }
+unsigned long micros() { return ((uint32_t)host_us); }
+uint64_t micros64() { return (host_us); }
+void delay (unsigned long ms) { host_us += 1000ULL*ms; }
+void delayMicroseconds (unsigned int us) { host_us += us; }
+void yield() { host_us += 1; }
+void resetWatchdog() { host_us += 1; }
+
+void pinMode (uint8_t, uint8_t) {}
+int digitalRead (uint8_t) { return (LOW); }
+void digitalWrite (uint8_t, uint8_t) {}
+void attachInterrupt (uint8_t pin, void (*isr)(void), int) { host_isr[pin&31] = isr; }
+void detachInterrupt (uint8_t pin) { host_isr[pin&31] = NULL; }
+
+void host_interrupt (uint8_t pin)
+{
+	if (host_isr[pin&31])
+	    (*host_isr[pin&31])();
+}
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+EspClass ESP;
+TwoWire Wire;
+uint8_t wire_result;
+std::function<bool(uint8_t, uint8_t, uint8_t *, uint8_t)> wire_read;
+uint8_t TwoWire::endTransmission (bool) { return (wire_result); }
+
+uint8_t TwoWire::requestFrom (uint8_t a, uint8_t n)
+{
+	if (n > sizeof(rbuf))
+	    n = sizeof(rbuf);
+	memset (rbuf, 0, n);
+	ri = rn = 0;
+	if (wire_result != 0 || (wire_read && !wire_read (a, reg, rbuf, n)))
+	    return (0);
+	rn = n;
+	return (n);
+}
+EEPROMClass EEPROM;
+WiFiClass WiFi;
+bool wifi_dns_ok = true;
+int wifi_dns_calls;
+uint32_t wifi_dns_ms;
+std::deque<Packet> udp_replies;
+std::vector<Packet> udp_sent;
+SoftwareSerial *SoftwareSerial::last;
+std::function<void(SoftwareSerial *)> SoftwareSerial::on_create;
+
+int WiFiUDP::parsePacket()
+{
+	if (udp_replies.empty())
+	    return (0);
+	in = udp_replies.front();
+	udp_replies.pop_front();
+	in_i = 0;
+	return ((int)in.size());
+}
+int host_failures;
@@ -0,0 +1,13 @@
+/* host Control for tests of its collaborators: the default periods, never runs.
+ */
+
+#include "Control.h"
+
+
+Control::Control()
+{
+	memset (step, 0, sizeof(step));
+	step[SENSE].period = SENSE_MS;
+	step[ESTIMATE].period = ESTIMATE_MS;
+	step[ACTUATE].period = ACTUATE_MS;
+}
@@ -0,0 +1,28 @@
+/* host Gimbal for tests of its collaborators: counts the steps it is asked to run and keeps
+ * the most recent pass it was asked to plan.
+ */
+
+#include "Gimbal.h"
+
+int gimbal_estimates, gimbal_profiles;
+
+Gimbal::Gimbal()
+{
+	gimbal_found = true;
+	init_step = N_INIT_STEPS;
+}
+void Gimbal::estimate() { gimbal_estimates++; }
+void Gimbal::stepProfile() { gimbal_profiles++; }
+void Gimbal::moveToAzEl (float az_t, float el_t, float az_rate, float el_rate, float az_acc, float el_acc) {}
+
+int gimbal_plans;
+SkyPoint gimbal_path[20];		// as MAX_PATH
+uint8_t gimbal_npath;
+bool gimbal_up;
+void Gimbal::planPass (const SkyPoint *sp, uint8_t n, bool up)
+{
+	gimbal_plans++;
+	gimbal_npath = n < 20 ? n : 20;
+	memcpy (gimbal_path, sp, gimbal_npath*sizeof(SkyPoint));
+	gimbal_up = up;
+}
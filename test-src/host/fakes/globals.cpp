@@ -0,0 +1,18 @@
+/* the module instances AutoSatTracker-ESP.ino defines, a test makes the ones it needs.
+ */
+
+#include "NV.h"
+#include "Sensor.h"
+#include "Circum.h"
+#include "Gimbal.h"
+#include "Target.h"
+#include "Control.h"
+#include "Webpage.h"
+
+NV *nv;
+Sensor *sensor;
+Circum *circum;
+Gimbal *gimbal;
+Target *target;
+Control *control;
+Webpage *webpage;
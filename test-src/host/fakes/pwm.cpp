@@ -0,0 +1,15 @@
+/* host PWM servo driver: keeps the pulse last set on each channel, in 12 bit ticks.
+ */
+
+#include <Adafruit_PWMServoDriver.h>
+
+uint16_t pwm_ticks[16];
+
+Adafruit_PWMServoDriver::Adafruit_PWMServoDriver (TwoWire *i2c, uint8_t addr) : _i2caddr(addr), _i2c(i2c) {}
+void Adafruit_PWMServoDriver::begin (uint8_t) {}
+void Adafruit_PWMServoDriver::setPWMFreq (float) {}
+
+void Adafruit_PWMServoDriver::setPWM (uint8_t num, uint16_t on, uint16_t off)
+{
+	pwm_ticks[num & 15] = off;
+}
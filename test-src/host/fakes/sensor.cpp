@@ -0,0 +1,45 @@
+/* host Sensor for tests of its collaborators: each update() samples wherever sensor_point says
+ * the antenna points, and a window is however many samples have been taken since, all alike.
+ */
+
+#include <functional>
+
+#include "Sensor.h"
+#include "Control.h"
+
+std::function<void(float &az, float &el)> sensor_point;
+
+Sensor::Sensor()
+{
+	sensor_found = true;
+	sampled = false;
+	memset (&sample, 0, sizeof(sample));
+}
+
+void Sensor::update()
+{
+	sensor_point (sample.az, sample.el);
+	sample.ms = millis();
+	sampled = true;
+}
+
+uint32_t Sensor::getAzEl (float *azp, float *elp)
+{
+	if (!sampled)
+	    update();
+	*azp = sample.az;
+	*elp = sample.el;
+	return (millis() - sample.ms);
+}
+
+bool Sensor::getWindow (Window &w, uint32_t since_ms)
+{
+	if (!sampled || (int32_t)(sample.ms - since_ms) <= 0)
+	    return (false);
+	uint32_t n = (sample.ms - since_ms)/control->period(Control::SENSE) + 1;
+	w.n = n < HISTORY_N ? n : HISTORY_N;
+	w.az_med = w.az_mean = sample.az;
+	w.el_med = w.el_mean = sample.el;
+	w.az_var = w.el_var = 0;
+	return (w.n >= 2);
+}
@@ -0,0 +1,18 @@
+/* host Target for tests of its collaborators: counts what it is asked to do.
+ */
+
+#include "Target.h"
+
+int target_topo, target_pass, target_path, target_sun;
+
+Target::Target() {}
+void Target::updateTopo() { target_topo++; }
+void Target::findNextPass() { target_pass++; }
+void Target::computeSkyPath() { target_path++; }
+void Target::pointAtSun() { target_sun++; }
+
+bool target_tracking;
+void Target::setTrackingState (bool on) { target_tracking = on; }
+
+int target_tracks;
+void Target::track() { target_tracks++; }
@@ -0,0 +1,18 @@
+/* host Webpage for tests of its collaborators: keeps the most recent user message.
+ */
+
+#include "Webpage.h"
+
+std::string webpage_msg;
+
+Webpage::Webpage() {}
+
+void Webpage::setUserMessage (const __FlashStringHelper *ifsh)
+{
+	webpage_msg = (const char *)ifsh;
+}
+
+void Webpage::setUserMessage (const __FlashStringHelper *ifsh, const char *msg, char state)
+{
+	webpage_msg = std::string((const char *)ifsh) + msg + state;
+}
@@ -0,0 +1,79 @@
+/* a simulated MTK receiver for the Circum tests: NMEA sentences and PPS edges from a true time,
+ * received by a local clock that runs at its own rate.
+ */
+
+#ifndef _GPSSIM_H
+#define _GPSSIM_H
+
+#include <string>
+#include <SoftwareSerial.h>
+
+#include "host.h"
+#include "P13.h"
+
+#define	SIM_PPS_PIN	14			// Circum's GPS_PPS_PIN
+
+class GPSSim {
+
+    public:
+
+	double drift;			// local clock rate error, local/true - 1
+	double t0;			// true secs since 1970 at host_us == 0
+	SoftwareSerial *ss;		// the port Circum reads
+
+	GPSSim (double t0_, double drift_) : drift(drift_), t0(t0_), ss(SoftwareSerial::last) {}
+
+	// local micros64() when the true time is t
+	uint64_t localUs (double t) { return ((uint64_t)((t - t0)*1e6*(1 + drift) + 0.5)); }
+
+	// true time now
+	double trueNow() { return (t0 + host_us*1e-6/(1 + drift)); }
+
+	// return s with $ prefix and *checksum CRLF suffix
+	static std::string frame (const std::string &s) {
+	    uint8_t cs = 0;
+	    for (char c : s)
+		cs ^= c;
+	    char tail[8];
+	    snprintf (tail, sizeof(tail), "*%02X\r\n", cs);
+	    return ("$" + s + tail);
+	}
+
+	// RMC then GGA labeled with whole true second t.
+	// N.B. kept short so each fits in one Circum::checkGPS() call
+	static std::string fix (long t) {
+	    long day = t/86400, sod = t%86400;
+	    DateTime d (1970, 1, 1, 0, 0, 0);
+	    d.DN += day;
+	    int y; uint8_t mo, dd, h, m, s;
+	    d.gettime (y, mo, dd, h, m, s);
+	    char hms[16], dmy[12], b[120];
+	    snprintf (hms, sizeof(hms), "%02ld%02ld%02ld", sod/3600, (sod/60)%60, sod%60);
+	    snprintf (dmy, sizeof(dmy), "%02d%02d%02d", dd, mo, y%100);
+	    snprintf (b, sizeof(b), "GPRMC,%s,A,3000.00,N,11000.00,W,0,0,%s,,", hms, dmy);
+	    std::string out = frame (b);
+	    snprintf (b, sizeof(b), "GPGGA,%s,3000.00,N,11000.00,W,1,08,0.9,700.0,M,0.0,M,,", hms);
+	    return (out + frame (b));
+	}
+
+	// fire the PPS ISR now
+	static void edge() { host_interrupt (SIM_PPS_PIN); }
+};
+
+// seconds from a to b
+static inline double dtSecs (const DateTime &a, const DateTime &b)
+{
+	return (86400.0*((b.DN - a.DN) + ((double)b.TN - (double)a.TN)));
+}
+
+// DateTime at true secs since 1970 t
+static inline DateTime unixDT (double t)
+{
+	DateTime d (1970, 1, 1, 0, 0, 0);
+	long day = (long)floor(t/86400);
+	d.DN += day;
+	d.TN = (float)((t - 86400.0*day)/86400);
+	return (d);
+}
+
+#endif // _GPSSIM_H
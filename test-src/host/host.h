@@ -0,0 +1,63 @@
+/* shared helpers for the host tests.
+ */
+
+#ifndef _HOST_H
+#define _HOST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <WiFiClient.h>
+
+// fake clock, only moves when a test moves it
+extern uint64_t host_us;
+
+// run the ISR attached to the given pin
+extern void host_interrupt (uint8_t pin);
+
+extern int host_failures;
+
+#define CHECK(cond) do {							\
+	if (!(cond)) {								\
+	    fprintf (stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);	\
+	    host_failures++;							\
+	}									\
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol) do {						\
+	double _a = (a), _b = (b);						\
+	if (!(fabs(_a - _b) <= (tol))) {					\
+	    fprintf (stderr, "%s:%d: CHECK failed: %s = %g, want %g +- %g\n",	\
+	    	__FILE__, __LINE__, #a, _a, _b, (double)(tol));			\
+	    host_failures++;							\
+	}									\
+    } while (0)
+
+// return the value of NAME in the NAME=VALUE lines a sendNewValues() printed, or "" if absent
+static inline std::string hostValue (const std::string &lines, const char *name)
+{
+	std::string key = std::string("\n") + name + "=";
+	size_t i = ("\n" + lines).find (key);
+	if (i == std::string::npos)
+	    return ("");
+	i += key.size() - 1;
+	size_t e = lines.find_first_of ("\r\n", i);
+	return (lines.substr (i, e == std::string::npos ? std::string::npos : e - i));
+}
+
+// return what obj.sendNewValues() prints
+template <typename T> std::string hostValues (T &obj)
+{
+	WiFiClient client;
+	obj.sendNewValues (client);
+	return (*client.sink);
+}
+
+// report and exit, for the end of each test main()
+static inline int hostDone (const char *name)
+{
+	printf ("%s: %s\n", name, host_failures ? "FAIL" : "ok");
+	return (host_failures ? 1 : 0);
+}
+
+#endif // _HOST_H
@@ -0,0 +1,160 @@
+/* just enough of the ESP8266 Arduino core to build the tracker sources on a host for testing.
+ * time only moves when a test moves it, see host.h.
+ */
+
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+class __FlashStringHelper;
+#define F(s)			((const __FlashStringHelper *)(s))
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+#define pgm_read_byte(p)	(*(const uint8_t *)(p))
+#define pgm_read_word(p)	(*(const uint16_t *)(p))
+#define pgm_read_dword(p)	(*(const uint32_t *)(p))
+#define pgm_read_float(p)	(*(const float *)(p))
+
+#define HIGH		1
+#define LOW		0
+#define INPUT		0
+#define OUTPUT		1
+#define INPUT_PULLUP	2
+#define RISING		1
+#define FALLING		2
+#define CHANGE		3
+#define DEC		10
+#define HEX		16
+#define OCT		8
+#define BIN		2
+
+#define PI		3.1415926535897932384626433832795
+#define HALF_PI		1.5707963267948966192313216916398
+#define TWO_PI		6.283185307179586476925286766559
+#define DEG_TO_RAD	0.017453292519943295769236907684886
+#define RAD_TO_DEG	57.295779513082320876798154814105
+#define radians(deg)	((deg)*DEG_TO_RAD)
+#define degrees(rad)	((rad)*RAD_TO_DEG)
+#define sq(x)		((x)*(x))
+#define constrain(x,a,b) ((x)<(a)?(a):((x)>(b)?(b):(x)))
+#define digitalPinToInterrupt(p) (p)
+using std::min;
+using std::max;
+
+unsigned long millis();
+unsigned long micros();
+uint64_t micros64();
+void delay (unsigned long ms);
+void delayMicroseconds (unsigned int us);
+void yield();
+void pinMode (uint8_t pin, uint8_t mode);
+int digitalRead (uint8_t pin);
+void digitalWrite (uint8_t pin, uint8_t val);
+void attachInterrupt (uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt (uint8_t pin);
+
+class Print {
+    public:
+	virtual ~Print() {}
+	virtual size_t write (uint8_t c) = 0;
+	virtual size_t write (const uint8_t *buf, size_t n) {
+	    for (size_t i = 0; i < n; i++)
+		write (buf[i]);
+	    return (n);
+	}
+	size_t write (const char *s) { return (write ((const uint8_t *)s, strlen(s))); }
+	virtual void flush() {}
+
+	size_t print (const __FlashStringHelper *s) { return (write ((const char *)s)); }
+	size_t print (const char *s) { return (write (s)); }
+	size_t print (char c) { return (write ((uint8_t)c)); }
+	size_t print (unsigned char v, int base = DEC) { return (print ((unsigned long)v, base)); }
+	size_t print (int v, int base = DEC) { return (print ((long)v, base)); }
+	size_t print (unsigned int v, int base = DEC) { return (print ((unsigned long)v, base)); }
+	size_t print (long v, int base = DEC) {
+	    if (base == DEC) {
+		char b[24];
+		snprintf (b, sizeof(b), "%ld", v);
+		return (write (b));
+	    }
+	    return (print ((unsigned long)v, base));
+	}
+	size_t print (unsigned long v, int base = DEC) {
+	    char b[72], *p = &b[sizeof(b)-1];
+	    *p = '\0';
+	    do {
+		int d = v % base;
+		*--p = d < 10 ? '0' + d : 'A' + d - 10;
+		v /= base;
+	    } while (v);
+	    return (write (p));
+	}
+	size_t print (double v, int digits = 2) {
+	    char b[48];
+	    snprintf (b, sizeof(b), "%.*f", digits, v);
+	    return (write (b));
+	}
+
+	size_t println() { return (write ("\r\n")); }
+	template <typename T> size_t println (T v) { size_t n = print (v); return (n + println()); }
+	template <typename T> size_t println (T v, int f) { size_t n = print (v, f); return (n + println()); }
+};
+
+class Stream : public Print {
+    public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	size_t readBytes (uint8_t *buf, size_t n) {
+	    size_t i;
+	    for (i = 0; i < n && available() > 0; i++)
+		buf[i] = read();
+	    return (i);
+	}
+	size_t readBytes (char *buf, size_t n) { return (readBytes ((uint8_t *)buf, n)); }
+	void setTimeout (unsigned long) {}
+};
+
+/* debug output, kept so a test can look at it
+ */
+class HardwareSerial : public Stream {
+    public:
+	std::string out;
+	void begin (unsigned long) {}
+	void end() {}
+	void swap() {}
+	size_t setRxBufferSize (size_t n) { return (n); }
+	bool hasOverrun() { return (false); }
+	void updateBaudRate (unsigned long) {}
+	int available() { return (0); }
+	int read() { return (-1); }
+	int peek() { return (-1); }
+	size_t write (uint8_t c) { out += (char)c; return (1); }
+	using Print::write;
+};
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+class EspClass {
+    public:
+	void wdtDisable() {}
+	void wdtFeed() {}
+	void restart() {}
+	uint32_t getFreeHeap() { return (40000); }
+};
+extern EspClass ESP;
+
+#endif // _HOST_ARDUINO_H
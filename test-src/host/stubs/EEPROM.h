@@ -0,0 +1,16 @@
+#ifndef _HOST_EEPROM_H
+#define _HOST_EEPROM_H
+
+#include "Arduino.h"
+
+class EEPROMClass {
+    public:
+	uint8_t mem[4096];
+	void begin (size_t) {}
+	uint8_t read (int i) { return (mem[i]); }
+	void write (int i, uint8_t v) { mem[i] = v; }
+	bool commit() { return (true); }
+};
+extern EEPROMClass EEPROM;
+
+#endif // _HOST_EEPROM_H
@@ -0,0 +1,39 @@
+/* host WiFi: always connected, name lookups succeed unless a test sets wifi_dns_ok false.
+ * lookups are counted and, if they give one, their timeout is kept.
+ */
+
+#ifndef _HOST_ESP8266WIFI_H
+#define _HOST_ESP8266WIFI_H
+
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+
+#define WL_CONNECTED	3
+#define WIFI_STA	1
+#define WIFI_AP		2
+
+extern bool wifi_dns_ok;
+extern int wifi_dns_calls;
+extern uint32_t wifi_dns_ms;		// timeout given to the most recent lookup
+
+class WiFiClass {
+    public:
+	void mode (int) {}
+	void begin (const char *, const char *) {}
+	void config (IPAddress, IPAddress, IPAddress) {}
+	int status() { return (WL_CONNECTED); }
+	IPAddress localIP() { return (IPAddress (192,168,1,2)); }
+	int hostByName (const char *, IPAddress &ip) {
+	    wifi_dns_calls++;
+	    if (wifi_dns_ok)
+		ip = IPAddress (10,0,0,1);
+	    return (wifi_dns_ok);
+	}
+	int hostByName (const char *name, IPAddress &ip, uint32_t ms) {
+	    wifi_dns_ms = ms;
+	    return (hostByName (name, ip));
+	}
+};
+extern WiFiClass WiFi;
+
+#endif // _HOST_ESP8266WIFI_H
@@ -0,0 +1,58 @@
+/* host SoftwareSerial: a test queues received bytes in rx and finds sent bytes in tx.
+ * on_read runs before each byte is taken so a test can make things happen mid-sentence,
+ * on_write runs after each write so a test can play the receiver answering.
+ */
+
+#ifndef _HOST_SOFTWARESERIAL_H
+#define _HOST_SOFTWARESERIAL_H
+
+#include <deque>
+#include <functional>
+#include "Arduino.h"
+
+enum SoftwareSerialConfig { SWSERIAL_8N1 };
+
+class SoftwareSerial : public Stream {
+    public:
+	std::deque<uint8_t> rx;
+	std::string tx;
+	std::function<void()> on_read;
+	std::function<void()> on_write;
+	bool overflowed;
+	SoftwareSerial() : overflowed(false) {
+	    last = this;
+	    if (on_create)
+		on_create (this);
+	}
+	static SoftwareSerial *last;		// most recent instance, the one the unit under test made
+	static std::function<void(SoftwareSerial *)> on_create;	// lets a test hook a port made in a ctor
+
+	void begin (int32_t, int8_t, int8_t = -1, SoftwareSerialConfig = SWSERIAL_8N1, bool = false,
+		int = 64, int = 0) {}
+	bool overflow() { bool o = overflowed; overflowed = false; return (o); }
+	int available() { return ((int)rx.size()); }
+	int read() {
+	    if (on_read) {
+		std::function<void()> f = on_read;	// hook may replace itself
+		f();
+	    }
+	    if (rx.empty())
+		return (-1);
+	    int c = rx.front();
+	    rx.pop_front();
+	    return (c);
+	}
+	int peek() { return (rx.empty() ? -1 : rx.front()); }
+	size_t write (uint8_t c) {
+	    tx += (char)c;
+	    if (on_write) {
+		std::function<void()> f = on_write;
+		f();
+	    }
+	    return (1);
+	}
+	using Print::write;
+	void send (const std::string &s) { rx.insert (rx.end(), s.begin(), s.end()); }
+};
+
+#endif // _HOST_SOFTWARESERIAL_H
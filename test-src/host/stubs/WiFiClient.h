@@ -0,0 +1,36 @@
+/* host WiFiClient: everything printed is appended to a string shared by all copies, so a test
+ * can read what a sendNewValues() passed by value would have sent to the browser.
+ */
+
+#ifndef _HOST_WIFICLIENT_H
+#define _HOST_WIFICLIENT_H
+
+#include <memory>
+#include "Arduino.h"
+
+class IPAddress {
+    public:
+	uint8_t b[4];
+	IPAddress() { b[0] = b[1] = b[2] = b[3] = 0; }
+	IPAddress (uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) { b[0]=b0; b[1]=b1; b[2]=b2; b[3]=b3; }
+	uint8_t &operator[] (int i) { return (b[i]); }
+	uint8_t operator[] (int i) const { return (b[i]); }
+	operator uint32_t() const { return (b[0] | b[1]<<8 | b[2]<<16 | (uint32_t)b[3]<<24); }
+};
+
+class WiFiClient : public Stream {
+    public:
+	std::shared_ptr<std::string> sink;
+	WiFiClient() : sink (new std::string) {}
+	size_t write (uint8_t c) { *sink += (char)c; return (1); }
+	using Print::write;
+	int available() { return (0); }
+	int read() { return (-1); }
+	int peek() { return (-1); }
+	uint8_t connected() { return (1); }
+	void stop() {}
+	operator bool() { return (true); }
+	IPAddress remoteIP() { return (IPAddress()); }
+};
+
+#endif // _HOST_WIFICLIENT_H
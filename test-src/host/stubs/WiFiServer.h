@@ -0,0 +1,13 @@
+#ifndef _HOST_WIFISERVER_H
+#define _HOST_WIFISERVER_H
+
+#include "WiFiClient.h"
+
+class WiFiServer {
+    public:
+	WiFiServer (uint16_t) {}
+	void begin() {}
+	WiFiClient available() { return (WiFiClient()); }
+};
+
+#endif // _HOST_WIFISERVER_H
@@ -0,0 +1,44 @@
+/* host WiFiUDP: a test queues whole reply packets in udp_replies and finds each packet sent
+ * in udp_sent.
+ */
+
+#ifndef _HOST_WIFIUDP_H
+#define _HOST_WIFIUDP_H
+
+#include <deque>
+#include <vector>
+#include "WiFiClient.h"
+
+typedef std::vector<uint8_t> Packet;
+extern std::deque<Packet> udp_replies;
+extern std::vector<Packet> udp_sent;
+
+class WiFiUDP : public Stream {
+    private:
+	Packet in, out;
+	size_t in_i;
+    public:
+	WiFiUDP() : in_i(0) {}
+	uint8_t begin (uint16_t) { return (1); }
+	void stop() {}
+	int beginPacket (IPAddress, uint16_t) { out.clear(); return (1); }
+	int endPacket() { udp_sent.push_back (out); return (1); }
+	int parsePacket();
+	int available() { return ((int)(in.size() - in_i)); }
+	int read() { return (in_i < in.size() ? in[in_i++] : -1); }
+	int read (uint8_t *buf, size_t n) {
+	    size_t i;
+	    for (i = 0; i < n && in_i < in.size(); i++)
+		buf[i] = in[in_i++];
+	    return ((int)i);
+	}
+	int peek() { return (in_i < in.size() ? in[in_i] : -1); }
+	void flush() { in_i = in.size(); }
+	size_t write (uint8_t c) { out.push_back (c); return (1); }
+	size_t write (const uint8_t *buf, size_t n) { out.insert (out.end(), buf, buf+n); return (n); }
+	using Print::write;
+	IPAddress remoteIP() { return (IPAddress()); }
+	uint16_t remotePort() { return (123); }
+};
+
+#endif // _HOST_WIFIUDP_H
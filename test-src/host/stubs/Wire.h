@@ -0,0 +1,51 @@
+/* host Wire: a test answers register reads with wire_read, writes are dropped.
+ * transmissions end with wire_result, 0 for success.
+ */
+
+#ifndef _HOST_WIRE_H
+#define _HOST_WIRE_H
+
+#include <functional>
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+    private:
+	uint8_t addr, reg;
+	bool have_reg;
+	uint8_t rbuf[64];
+	uint8_t rn, ri;
+    public:
+	TwoWire() : addr(0), reg(0), have_reg(false), rn(0), ri(0) {}
+	void begin() {}
+	void begin (int, int) {}
+	void setClock (uint32_t) {}
+	void setClockStretchLimit (uint32_t) {}
+	void beginTransmission (uint8_t a) { addr = a; have_reg = false; }
+	uint8_t endTransmission (bool = true);
+	uint8_t requestFrom (uint8_t a, uint8_t n);
+	uint8_t requestFrom (uint8_t a, uint8_t n, uint8_t) { return (requestFrom (a, n)); }
+	uint8_t requestFrom (int a, int n) { return (requestFrom ((uint8_t)a, (uint8_t)n)); }
+	size_t write (uint8_t c) {
+	    if (!have_reg) {
+		reg = c;
+		have_reg = true;
+	    }
+	    return (1);
+	}
+	size_t write (const uint8_t *buf, size_t n) {
+	    for (size_t i = 0; i < n; i++)
+		write (buf[i]);
+	    return (n);
+	}
+	using Print::write;
+	int available() { return (rn - ri); }
+	int read() { return (ri < rn ? rbuf[ri++] : -1); }
+	int peek() { return (ri < rn ? rbuf[ri] : -1); }
+};
+extern TwoWire Wire;
+extern uint8_t wire_result;
+
+// fill buf with n registers of device addr starting at reg, return whether it answers
+extern std::function<bool(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t n)> wire_read;
+
+#endif // _HOST_WIRE_H
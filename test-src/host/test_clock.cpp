@@ -0,0 +1,100 @@
+/* Circum calendar cache: the date and time shown as the seconds and the day roll over, and the GPS
+ * lock lapsing when the receiver goes quiet.
+ */
+
+#include "Circum.h"
+#include "gpssim.h"
+
+// set op time to date and time, each given as space separated fields
+static void setTime (Circum &c, const char *date, const char *utc)
+{
+	char n1[] = "GPS_Date", n2[] = "GPS_UTC";
+	char v1[32], v2[32];
+	strcpy (v1, date);
+	strcpy (v2, utc);
+	c.overrideValue (n1, v1);
+	c.overrideValue (n2, v2);
+}
+
+// return the GPS_Date and GPS_UTC values shown, without the override marks
+static std::string shown (Circum &c)
+{
+	std::string v = hostValues (c);
+	std::string d = hostValue (v, "GPS_Date"), t = hostValue (v, "GPS_UTC");
+	if (!d.empty() && d.back() == '!')
+	    d.pop_back();
+	if (!t.empty() && t.back() == '!')
+	    t.pop_back();
+	return (d + " " + t);
+}
+
+/* the second steps through a minute and an hour
+ */
+static void testSeconds()
+{
+	host_us = 0;
+	Circum c;
+	setTime (c, "2024 3 10", "10 58 58");
+	CHECK (shown (c) == "2024 3 10 10:58:58");
+	host_us += 1000000;
+	CHECK (shown (c) == "2024 3 10 10:58:59");
+	host_us += 1000000;
+	CHECK (shown (c) == "2024 3 10 10:59:00");
+	host_us += 60000000;
+	CHECK (shown (c) == "2024 3 10 11:00:00");
+}
+
+/* a new day must not step from the last second of the old one
+ */
+static void testMidnight()
+{
+	host_us = 0;
+	Circum c;
+	setTime (c, "2024 3 10", "23 59 31");
+	CHECK (shown (c) == "2024 3 10 23:59:31");
+	host_us += 29500000;
+	CHECK (shown (c) == "2024 3 11 0:00:00");
+	host_us += 1000000;
+	CHECK (shown (c) == "2024 3 11 0:00:01");
+
+	// and over a year end
+	setTime (c, "2024 12 31", "23 59 59");
+	CHECK (shown (c) == "2024 12 31 23:59:59");
+	host_us += 1000000;
+	CHECK (shown (c) == "2025 1 1 0:00:00");
+}
+
+/* a receiver that goes quiet completes no sentences, yet its lock must still lapse once the
+ * last fix is GPS_STALE old, before holdover is declared
+ */
+static void testQuiet()
+{
+	host_us = 0;
+	Circum c;
+	GPSSim g (1710072000.0, 0);
+
+	long t = (long)g.trueNow();
+	for (int i = 0; i < 5; i++, t++) {
+	    host_us = g.localUs (t + 0.3);
+	    g.ss->send (GPSSim::fix (t));
+	    for (int j = 0; j < 20; j++, host_us += 50000)
+		c.checkGPS();
+	}
+	CHECK (hostValue (hostValues (c), "GPS_Status") == "Locked+");
+
+	// last fix was at t - 0.7, keep polling with nothing arriving
+	host_us = g.localUs (t + 1.2);
+	c.checkGPS();
+	CHECK (hostValue (hostValues (c), "GPS_Status") == "Locked+");
+	for (; host_us < g.localUs (t + 1.6); host_us += 50000)
+	    c.checkGPS();
+	CHECK (hostValue (hostValues (c), "GPS_Status") == "No lock!");
+}
+
+int main()
+{
+	testSeconds();
+	testMidnight();
+	testQuiet();
+	return (hostDone ("test_clock"));
+}
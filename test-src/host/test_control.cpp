@@ -0,0 +1,83 @@
+/* host test of Control: the lateness and skipped runs it reports cover a fixed window, so every
+ * page polling it sees the same figures however often each one asks.
+ */
+
+#include <functional>
+
+#include "host.h"
+#include "NV.h"
+#include "Sensor.h"
+#include "Gimbal.h"
+#include "Target.h"
+#include "Control.h"
+#include "Webpage.h"
+
+extern std::function<void(float &az, float &el)> sensor_point;
+extern int gimbal_estimates, target_tracks;
+
+static uint32_t stall_ms;			// next sensor read takes this long
+
+/* run the loop for ms, calling Control as often as a 1 ms loop() would
+ */
+static void runFor (uint32_t ms)
+{
+	for (uint32_t i = 0; i < ms; i++) {
+	    host_us += 1000;
+	    control->run();
+	}
+}
+
+static std::string status (std::string v)
+{
+	return (hostValue (v, "C_Status") + " " + hostValue (v, "C_SenseLate") + " "
+		+ hostValue (v, "C_EstLate") + " " + hostValue (v, "C_ActLate"));
+}
+
+/* a stall early in one window shows in the next, the same to two tabs polling at their own
+ * times, then clears a window later
+ */
+static void testWindow()
+{
+	runFor (3000);
+	CHECK (gimbal_estimates >= 59 && gimbal_estimates <= 61);
+	CHECK (target_tracks >= 29 && target_tracks <= 31);
+	stall_ms = 250;
+	runFor (9000);
+
+	std::string a1 = status (hostValues (*control));
+	runFor (200);
+	std::string b = status (hostValues (*control));
+	runFor (300);
+	std::string a2 = status (hostValues (*control));
+	CHECK (hostValue (hostValues (*control), "C_Status").find (" late!") != std::string::npos);
+	CHECK (a1 == b);
+	CHECK (a2 == b);
+	std::string late = hostValue (hostValues (*control), "C_EstLate");
+	CHECK (late.back() == '!');
+	CHECK (atof (late.substr (late.find ('/') + 1).c_str()) > 150);
+
+	runFor (10000);
+	std::string v = hostValues (*control);
+	CHECK (hostValue (v, "C_Status") == "Ok+");
+	late = hostValue (v, "C_EstLate");
+	CHECK (late.back() != '!');
+	CHECK (atof (late.substr (late.find ('/') + 1).c_str()) < 2);
+}
+
+int main()
+{
+	nv = new NV();
+	webpage = new Webpage();
+	sensor = new Sensor();
+	gimbal = new Gimbal();
+	target = new Target();
+	sensor_point = [] (float &az, float &el) {
+	    az = el = 0;
+	    host_us += 1000ULL*stall_ms;
+	    stall_ms = 0;
+	};
+	control = new Control();
+
+	testWindow();
+	return (hostDone ("test_control"));
+}
@@ -0,0 +1,504 @@
+/* host test of Gimbal: the motion profile and how a swaying antenna settles after it, the lead
+ * clamp, then a simulated mount turns the pulses sent to each servo into where the antenna points,
+ * closing the loop through a stand-in Sensor.
+ */
+
+#include <functional>
+#include <vector>
+
+#include "host.h"
+#include "NV.h"
+#include "Gimbal.h"
+#include "Target.h"
+#include "Control.h"
+#include "Webpage.h"
+
+extern uint16_t pwm_ticks[16];
+extern std::function<void(float &az, float &el)> sensor_point;
+
+// the mount: servo 0 turns az, servo 1 tips el from one horizon over the top to the other
+#define	US_PER_TICK	(1e6/50/4096)
+#define	AZ_MIN		400		// usec
+#define	AZ_MAX		2600
+#define	AZ_MID		1500		// points at AZ0
+#define	AZ0		30.0		// degs
+#define	AZ_SCALE	4.0		// usec/deg
+#define	EL_MIN		1000		// el 0, 180 at 2000, a little further allowed
+#define	EL_MAX		2050
+#define	EL_SCALE	(1000/180.0)
+
+/* where the mount points with servos at the given pulse widths
+ */
+static void mountAzEl (float p0, float p1, float &az, float &el)
+{
+	double ma = AZ0 + (p0 - AZ_MID)/AZ_SCALE;
+	double me = (p1 - EL_MIN)/EL_SCALE;
+	if (me > 90) {
+	    el = 180 - me;
+	    ma += 180;
+	} else
+	    el = me;
+	az = fmod (fmod (ma, 360) + 360, 360);
+}
+
+/* where the mount points with servos at the given commanded positions, as sent
+ */
+static void mountAzElAt (int pos0, int pos1, float &az, float &el)
+{
+	mountAzEl ((uint16_t)(pos0/US_PER_TICK)*US_PER_TICK, (uint16_t)(pos1/US_PER_TICK)*US_PER_TICK,
+		az, el);
+}
+
+/* a pass of length T secs along a great circle passing within off degs of the zenith, to the
+ * East if off > 0, rising at az a0 at t 0, below the horizon outside 0 .. T.
+ */
+#define	PASS_T		120.0
+static void passAzEl (double t, double off, float &az, float &el, double a0 = 0)
+{
+	double a = M_PI*t/PASS_T;
+	double d = radians (off);
+	el = degrees (asin (sin(a)*cos(d)));
+	az = fmod (degrees (atan2 (sin(a)*sin(d), cos(a))) + a0 + 720, 360);
+}
+
+/* the pass as Target sends it to be planned
+ */
+static void passPath (double off, double a0, SkyPoint path[20])
+{
+	for (int i = 0; i < 20; i++) {
+	    float az, el;
+	    passAzEl (PASS_T*i/19, off, az, el, a0);
+	    path[i].az = az;
+	    path[i].el = el;
+	}
+}
+
+static double azDiff (double a, double b)
+{
+	double d = fmod (a - b + 720, 360);
+	return (d > 180 ? d - 360 : d);
+}
+
+/* how the mount followed the target, added to by each run()
+ */
+typedef struct {
+	bool saw_flip;				// went over the top
+	float worst_track;			// worst pointing error with the pass 20 .. 80 up, degs
+	double err_sq;				// sum of square pointing errors with the pass 10 up
+	int n_err;				// n in err_sq
+	int at_limit;				// moves that reached a limit with the pass 2 up
+} Flight;
+
+static double rmsErr (const Flight &f)
+{
+	return (f.n_err ? sqrt (f.err_sq/f.n_err) : 0);
+}
+
+/* run the control steps for ms with the target following the pass from pass time t0, telling
+ * moveToAzEl its rates unless !rates. return the worst el estimate error just after a move
+ * commanded over the top with the pass up.
+ */
+static float run (Gimbal &g, uint32_t ms, double t0, double off, Flight &f, double a0 = 0,
+bool rates = true)
+{
+	float worst = 0;
+	for (uint32_t m = 10; m <= ms; m += 10) {
+	    host_us += 10000;
+	    g.stepProfile();
+	    if (m % control->period(Control::SENSE) == 0)
+		sensor->update();
+	    if (m % control->period(Control::ESTIMATE) == 0)
+		g.estimate();
+	    if (m % control->period(Control::ACTUATE) != 0)
+		continue;
+
+	    double t = t0 + m/1000.0;
+	    float az_t, el_t, az_1, el_1;
+	    passAzEl (t, off, az_t, el_t, a0);
+	    passAzEl (t + 1, off, az_1, el_1, a0);
+	    std::string before = hostValues (g);
+	    if (rates)
+		g.moveToAzEl (az_t, el_t, azDiff (az_1, az_t), el_1 - el_t, 0, 0);
+	    else
+		g.moveToAzEl (az_t, el_t, 0, 0, 0, 0);
+	    std::string after = hostValues (g);
+	    if (el_t > 2 && hostValue (after, "G_Status") != "Ok+")
+		f.at_limit++;
+
+	    // a fresh move is predicted to land where the mount will when it gets there
+	    bool moved = hostValue (before, "G_Mot1Pos") != hostValue (after, "G_Mot1Pos")
+		    || hostValue (before, "G_Mot2Pos") != hostValue (after, "G_Mot2Pos");
+	    if (hostValue (after, "G_Flipped") == "Yes") {
+		f.saw_flip = true;
+		if (moved && el_t > 0) {
+		    float az_m, el_m;
+		    mountAzElAt (atoi (hostValue (after, "G_Mot1Pos").c_str()),
+				    atoi (hostValue (after, "G_Mot2Pos").c_str()), az_m, el_m);
+		    float err = fabsf (atof (hostValue (after, "G_EstEl").c_str()) - el_m);
+		    if (err > worst)
+			worst = err;
+		}
+	    }
+
+	    // and the mount keeps up with the pass once it is well up
+	    float az_s, el_s;
+	    mountAzEl (pwm_ticks[0]*US_PER_TICK, pwm_ticks[1]*US_PER_TICK, az_s, el_s);
+	    float e = hypotf (azDiff (az_s, az_t)*cosf (radians (el_t)), el_s - el_t);
+	    if (el_t > 20 && el_t < 80 && e > f.worst_track)
+		f.worst_track = e;
+	    if (el_t > 10) {
+		f.err_sq += e*e;
+		f.n_err++;
+	    }
+	}
+	return (worst);
+}
+
+/* step the motion profile every 10 ms for ms, appending servo 0 output to x, usec
+ */
+static void profileFor (Gimbal &g, uint32_t ms, std::vector<double> &x)
+{
+	for (uint32_t m = 0; m < ms; m += 10) {
+	    host_us += 10000;
+	    g.stepProfile();
+	    x.push_back (pwm_ticks[0]*US_PER_TICK);
+	}
+}
+
+/* servo output ramps to each new position within the speed and acceleration limits, the same
+ * when the position changes mid move, and stops there without overshoot. speeds are taken over
+ * 200 ms so the 12 bit pulse steps matter little.
+ */
+static void testProfile()
+{
+	nv->get();
+	nv->mot0min = AZ_MIN;
+	nv->mot0max = AZ_MAX;
+	nv->scale_ok = 0;
+	nv->put();
+	wire_result = 0;
+	Gimbal g;
+
+	char n_pos[] = "G_Mot1Pos", n_vel[] = "G_MaxVel", n_acc[] = "G_MaxAcc";
+	char v_vel[] = "400", v_acc[] = "800", v_start[] = "1000", v_far[] = "2000", v_back[] = "1200";
+	CHECK (g.overrideValue (n_vel, v_vel));
+	CHECK (g.overrideValue (n_acc, v_acc));
+	std::string v = hostValues (g);
+	CHECK (hostValue (v, "G_MaxVel") == "400");
+	CHECK (hostValue (v, "G_MaxAcc") == "800");
+
+	// the first position is sent at once, there is nothing known to ramp from
+	g.overrideValue (n_pos, v_start);
+	std::vector<double> x;
+	profileFor (g, 100, x);
+	CHECK_NEAR (x.back(), 1000, US_PER_TICK);
+
+	// 1000 usec at 400 usec/s after 0.5 s each to speed up and slow down takes 3 s
+	x.clear();
+	g.overrideValue (n_pos, v_far);
+	profileFor (g, 2000, x);
+	g.overrideValue (n_pos, v_back);
+	profileFor (g, 5000, x);
+
+	const int W = 20;				// 200 ms
+	double tick = US_PER_TICK;
+	for (size_t i = 0; i < x.size(); i++) {
+	    double t = (i + 1)*0.01;
+	    if (t <= 0.5)
+		CHECK (x[i] - 1000 <= 800*t*t/2 + tick);
+	    CHECK (x[i] <= 2000 + tick);
+	    if (i >= 200)
+		CHECK (x[i] >= 1200 - tick);
+	}
+	double worst_v = 0, worst_dv = 0;
+	for (size_t i = W; i + W < x.size(); i++) {
+	    double v0 = (x[i] - x[i-W])/(W*0.01);
+	    double v1 = (x[i+W] - x[i])/(W*0.01);
+	    worst_v = fmax (worst_v, fmax (fabs (v0), fabs (v1)));
+	    worst_dv = fmax (worst_dv, fabs (v1 - v0));
+	}
+	CHECK (worst_v <= 400 + 2*tick/(W*0.01));
+	CHECK (worst_v >= 390);
+	CHECK (worst_dv <= 800*W*0.01 + 2*tick/(W*0.01));
+
+	// got to the new position and stopped there
+	CHECK_NEAR (x.back(), 1200, tick);
+	for (size_t i = x.size() - 100; i < x.size(); i++)
+	    CHECK (x[i] == x.back());
+
+	// limits are checked
+	char v_low[] = "5";
+	g.overrideValue (n_vel, v_low);
+	CHECK (hostValue (hostValues (g), "G_MaxVel") == "400");
+}
+
+/* a servo that slews at up to SERVO_VEL towards its pulse, carrying an antenna that sways on a
+ * springy mount, so a sudden change of servo speed sets the antenna ringing
+ */
+#define	SERVO_VEL	2000.0		// usec/sec
+#define	SERVO_GAIN	30.0		// 1/sec, speed per usec of error
+#define	SWAY_HZ		2.0		// antenna natural frequency
+#define	SWAY_DAMP	0.1		// and damping ratio
+typedef struct {
+	double s, sv;			// servo position, usec, and speed, usec/sec
+	double x, xv;			// antenna sway, degs, and its rate
+} SwayMount;
+
+/* advance m by ms towards pulse p, 1 ms at a time
+ */
+static void swayStep (SwayMount &m, double p, int ms)
+{
+	double w = 2*M_PI*SWAY_HZ;
+	for (int i = 0; i < ms; i++) {
+	    double dt = 0.001;
+	    double sv = fmax (fmin (SERVO_GAIN*(p - m.s), SERVO_VEL), -SERVO_VEL);
+	    m.xv += (-w*w*m.x - 2*SWAY_DAMP*w*m.xv)*dt - (sv - m.sv)/AZ_SCALE;
+	    m.x += m.xv*dt;
+	    m.sv = sv;
+	    m.s += sv*dt;
+	}
+}
+
+/* command servo 0 from start to end and return secs until the antenna stays within 1 deg of end.
+ * ramped sends the pulses stepProfile makes, else each command goes straight out as it did
+ * before. also return the worst sway, degs.
+ */
+static double settleTime (int start, int end, bool ramped, double &worst_sway)
+{
+	nv->get();
+	nv->mot0min = AZ_MIN;
+	nv->mot0max = AZ_MAX;
+	nv->scale_ok = 0;
+	nv->prof_ok = 0;
+	nv->put();
+	wire_result = 0;
+	Gimbal g;
+
+	char n_pos[] = "G_Mot1Pos", v_pos[16];
+	snprintf (v_pos, sizeof(v_pos), "%d", start);
+	g.overrideValue (n_pos, v_pos);
+	SwayMount m = {(double)start, 0, 0, 0};
+	snprintf (v_pos, sizeof(v_pos), "%d", end);
+	g.overrideValue (n_pos, v_pos);
+
+	std::vector<double> az;
+	double p = (uint16_t)(end/US_PER_TICK)*US_PER_TICK;
+	worst_sway = 0;
+	for (int ms = 10; ms <= 15000; ms += 10) {
+	    host_us += 10000;
+	    if (ramped) {
+		g.stepProfile();
+		p = pwm_ticks[0]*US_PER_TICK;
+	    }
+	    swayStep (m, p, 10);
+	    worst_sway = fmax (worst_sway, fabs (m.x));
+	    az.push_back (m.s/AZ_SCALE + m.x);
+	}
+
+	// where it ends up is where the last pulse sent puts it, 12 bits are about 1 deg
+	size_t i = az.size();
+	while (i > 0 && fabs (az[i-1] - p/AZ_SCALE) <= 1)
+	    i--;
+	return (i*0.01);
+}
+
+/* the ramp sets the antenna swaying much less than jumping straight to a new position, so it
+ * settles sooner after a tracking move. the swing back from an az limit to 80% of the range is
+ * mostly slewing, where the ramp is slower, so it settles about as soon but sways far less.
+ */
+static void testSettle()
+{
+	double sway_j, sway_r;
+	double jump = settleTime (1500, 1620, false, sway_j);
+	double ramp = settleTime (1500, 1620, true, sway_r);
+	printf ("30 degs step: settles in %.2f s jumping, %.2f s ramped, sway %.1f, %.1f degs\n",
+			jump, ramp, sway_j, sway_r);
+	CHECK (sway_r < 0.3*sway_j);
+
+	int swing = AZ_MIN + 0.8*(AZ_MAX - AZ_MIN);
+	double sjump = settleTime (AZ_MIN, swing, false, sway_j);
+	double sramp = settleTime (AZ_MIN, swing, true, sway_r);
+	printf ("az limit swing: settles in %.2f s jumping, %.2f s ramped, sway %.1f, %.1f degs\n",
+			sjump, sramp, sway_j, sway_r);
+	CHECK (ramp < 0.7*jump);
+	CHECK (sramp < sjump + 0.5);
+	CHECK (sway_r < 0.2*sway_j);
+}
+
+/* lead is how far the target goes in the lead time, but never more than 45 degs either way,
+ * as when az whips round near the zenith
+ */
+static void testLeadAngle()
+{
+	CHECK_NEAR (Gimbal::leadAngle (10, 5, 0), 0, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (2, 0, 500), 1, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (-3, 0, 500), -1.5, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (1, 4, 1000), 3, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (1, -4, 1000), -1, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (89, 0, 500), 44.5, 1e-4);
+	CHECK_NEAR (Gimbal::leadAngle (91, 0, 500), 45, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (-200, 0, 500), -45, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (0, 1000, 1000), 45, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (50, -1000, 1000), -45, 1e-6);
+	CHECK_NEAR (Gimbal::leadAngle (1e30, 1e30, 1000), 45, 1e-6);
+}
+
+/* save the mount limits and scales so a new Gimbal starts warm
+ */
+static void mountNV()
+{
+	nv->get();
+	nv->mot0min = AZ_MIN;
+	nv->mot0max = AZ_MAX;
+	nv->mot1min = EL_MIN;
+	nv->mot1max = EL_MAX;
+	nv->mot_scale[0][0] = AZ_SCALE;
+	nv->mot_scale[0][1] = 1e9;
+	nv->mot_scale[1][0] = 1e9;
+	nv->mot_scale[1][1] = EL_SCALE;
+	nv->best_azmotor = 0;
+	nv->scale_ok = NV::VALID;
+	nv->prof_ok = 0;
+	nv->put();
+}
+
+/* the estimate follows the mount over the top of a high pass and back down the far side
+ */
+static void testOverTheTop()
+{
+	mountNV();
+	wire_result = 0;
+	Gimbal g;
+	gimbal = &g;
+	CHECK (g.connected());
+
+	// settle and check the saved scales while waiting for the pass
+	Flight f = {};
+	run (g, 10000, -40, 2, f);
+	CHECK (g.calibrated());
+
+	// plan the pass, then follow it
+	SkyPoint path[20];
+	passPath (2, 0, path);
+	g.planPass (path, 20, false);
+	float worst = run (g, (PASS_T + 50)*1000, -30, 2, f);
+
+	CHECK (f.saw_flip);
+	CHECK_NEAR (worst, 0, 1.0);
+	CHECK_NEAR (f.worst_track, 0, 5.0);
+	CHECK (f.at_limit == 0);
+}
+
+/* fly an 85 degs pass from a fresh start, planned, with or without telling moveToAzEl the
+ * target rates. return the rms pointing error with the pass 10 up.
+ */
+static double flyHighPass (bool rates)
+{
+	mountNV();
+	wire_result = 0;
+	Gimbal g;
+	gimbal = &g;
+	Flight f = {};
+	run (g, 10000, -40, 5, f);
+
+	SkyPoint path[20];
+	passPath (5, 0, path);
+	g.planPass (path, 20, false);
+	run (g, 30000, -30, 5, f);
+	f.err_sq = f.n_err = 0;
+	run (g, PASS_T*1000, 0, 5, f, 0, rates);
+	CHECK (f.at_limit == 0);
+	return (rmsErr (f));
+}
+
+/* leading the target by how far it goes while a move takes effect follows a high pass more
+ * closely than stopping and correcting to where it is
+ */
+static void testFeedForward()
+{
+	double stop = flyHighPass (false);
+	double lead = flyHighPass (true);
+	printf ("85 degs pass rms error: stop and correct %.2f, feed forward %.2f degs\n", stop, lead);
+	CHECK (lead < 0.7*stop);
+}
+
+/* planner corpus: passes of each height rising all round the sky, each way, planned one after
+ * another from wherever the last left the mount. each plan keeps the whole pass within the
+ * motor limits, goes over the top only for high passes, is followed without reaching a limit,
+ * and is done once the pass sets. a pass sent while one is being followed replaces it only if
+ * it is not the rest of the same pass.
+ */
+static void testPlanCorpus()
+{
+	static const struct {
+	    double off;				// closest to zenith, degs, > 0 East
+	    bool flip;				// expected to go over the top
+	} heights[] = {
+	    {1, true}, {-8, true}, {12, true}, {-25, false}, {40, false}, {-60, false}, {78, false},
+	};
+	static const double rises[] = {0, 95, 170, 215, 290, 340};
+
+	mountNV();
+	wire_result = 0;
+	Gimbal g;
+	gimbal = &g;
+	Flight f = {};
+	run (g, 10000, -40, heights[0].off, f, rises[0]);
+	CHECK (g.calibrated());
+
+	int n_flip = 0;
+	for (const auto &h : heights) {
+	    for (double a0 : rises) {
+		SkyPoint path[20];
+		passPath (h.off, a0, path);
+		g.planPass (path, 20, false);
+		CHECK (hostValue (hostValues (g), "G_Plan") == "Pending");
+
+		// planned once settled waiting for the rise
+		run (g, 20000, -40, h.off, f, a0);
+		std::string plan = hostValue (hostValues (g), "G_Plan");
+		std::string want = h.flip ? "Flip+" : "Normal+";
+		if (plan != want)
+		    printf ("off %g rise %g: plan %s\n", h.off, a0, plan.c_str());
+		CHECK (plan == want);
+
+		// the rest of the same pass, as sent when it rises, leaves the plan alone
+		run (g, 20000, -20, h.off, f, a0);
+		passPath (h.off, a0, path);
+		g.planPass (path, 20, true);
+		CHECK (hostValue (hostValues (g), "G_Plan") == plan);
+
+		// follow it down, then it is done
+		int was = f.at_limit;
+		run (g, (PASS_T + 5)*1000, 0, h.off, f, a0);
+		if (f.at_limit > was)
+		    printf ("off %g rise %g: %d moves at a limit\n", h.off, a0, f.at_limit - was);
+		CHECK (hostValue (hostValues (g), "G_Plan") == "None");
+		n_flip += h.flip;
+	    }
+	}
+
+	CHECK (f.at_limit == 0);
+	CHECK_NEAR (f.worst_track, 0, 5.0);
+	CHECK (n_flip > 0 && f.saw_flip);
+}
+
+int main()
+{
+	nv = new NV();
+	control = new Control();
+	webpage = new Webpage();
+	target = new Target();
+	sensor = new Sensor();
+	sensor_point = [] (float &az, float &el) {
+	    mountAzEl (pwm_ticks[0]*US_PER_TICK, pwm_ticks[1]*US_PER_TICK, az, el);
+	};
+
+	testLeadAngle();
+	testProfile();
+	testSettle();
+	testFeedForward();
+	testOverTheTop();
+	testPlanCorpus();
+	return (hostDone ("test_gimbal"));
+}
@@ -0,0 +1,177 @@
+/* Circum SNTP fallback: offset and round trip from a scripted server, how often the server is
+ * looked up and asked when things go wrong, and taking over when the GPS goes quiet.
+ */
+
+#include "Circum.h"
+#include "gpssim.h"
+
+#define	T0		1710072000.25	// true unix secs at host_us 0
+#define	NTP_UNIX	2208988800.0	// NTP secs at 1970
+
+// true time now, local clock is perfect here
+static double trueNow() { return (T0 + host_us*1e-6); }
+
+// store true unix time t as an NTP 32.32 stamp at p
+static void putStamp (uint8_t *p, double t)
+{
+	double n = t + NTP_UNIX;
+	uint64_t s = ((uint64_t)floor(n) << 32) | (uint64_t)((n - floor(n))*4294967296.0);
+	for (int i = 0; i < 8; i++)
+	    p[i] = s >> (56 - 8*i);
+}
+
+/* answer the most recent request as a stratum 2 server that got it at true time t2 and sent
+ * the reply at t3
+ */
+static Packet reply (double t2, double t3)
+{
+	Packet r(48, 0);
+	const Packet &q = udp_sent.back();
+	r[0] = 0x24;				// LI 0, version 4, mode 4 server
+	r[1] = 2;
+	for (int i = 0; i < 8; i++)
+	    r[24+i] = q[40+i];			// origin is our transmit stamp
+	putStamp (&r[32], t2);
+	putStamp (&r[40], t3);
+	return (r);
+}
+
+// call checkNTP() every 100 ms for secs
+static void run (Circum &c, double secs)
+{
+	for (uint64_t end = host_us + (uint64_t)(secs*1e6); host_us < end; host_us += 100000)
+	    c.checkNTP();
+}
+
+/* 8 ms each way and 4 ms in the server: rtt is 16 ms and the time is right
+ */
+static void testReply()
+{
+	host_us = 0;
+	wifi_dns_ok = true;
+	wifi_dns_calls = 0;
+	udp_sent.clear();
+	udp_replies.clear();
+	Circum c;
+
+	c.checkNTP();
+	CHECK (udp_sent.size() == 1 && udp_sent[0].size() == 48 && udp_sent[0][0] == 0x23);
+	CHECK (wifi_dns_calls == 1 && wifi_dns_ms > 0 && wifi_dns_ms <= 2000);
+	double t1 = trueNow();
+	host_us += 20000;
+	udp_replies.push_back (reply (t1 + 0.008, t1 + 0.012));
+	c.checkNTP();
+
+	std::string v = hostValues (c);
+	CHECK (hostValue (v, "GPS_TimeSrc") == "NTP");
+	CHECK_NEAR (atof (hostValue (v, "GPS_NTPRtt").c_str()), 16.0, 0.1);
+	CHECK_NEAR (dtSecs (unixDT (trueNow()), c.now()), 0, 0.005);
+
+	// running on our own clock between polls is not holdover
+	run (c, 60);
+	CHECK (hostValue (hostValues (c), "GPS_Status") != "Holdover!");
+	CHECK (udp_sent.size() == 1);
+}
+
+/* no name server: lookups back off instead of blocking every NTP_RETRY
+ */
+static void testNoDNS()
+{
+	host_us = 0;
+	wifi_dns_ok = false;
+	wifi_dns_calls = 0;
+	udp_sent.clear();
+	Circum c;
+	host_us = 0;
+
+	// 10 s, then 20, 40, 80, 160 and 320 apart
+	run (c, 600);
+	CHECK (wifi_dns_calls == 6);
+	CHECK (udp_sent.empty());
+
+	// and give up no further than the normal poll
+	run (c, 3*3600);
+	CHECK (wifi_dns_calls <= 6 + 3*4 + 1);
+}
+
+/* a server that stops answering keeps its address until several requests in a row go unanswered,
+ * then an answer brings back the normal poll
+ */
+static void testTimeouts()
+{
+	host_us = 0;
+	wifi_dns_ok = true;
+	wifi_dns_calls = 0;
+	udp_sent.clear();
+	udp_replies.clear();
+	Circum c;
+	host_us = 0;
+
+	// requests at 0, 10, 30 and 70 s, all time out
+	run (c, 100);
+	CHECK (udp_sent.size() == 4);
+	CHECK (wifi_dns_calls == 1);
+
+	// the next one looks the server up again, and is answered
+	run (c, 50.05);
+	CHECK (udp_sent.size() == 5);
+	CHECK (wifi_dns_calls == 2);
+	double t1 = trueNow();
+	host_us += 20000;
+	udp_replies.push_back (reply (t1 + 0.008, t1 + 0.012));
+	run (c, 600);
+	CHECK (hostValue (hostValues (c), "GPS_TimeSrc") == "NTP");
+	CHECK (udp_sent.size() == 5);
+}
+
+/* GPS locks, so SNTP keeps quiet, then the receiver stops sending: once its fix goes stale SNTP
+ * must ask, and its answer sets the time
+ */
+static void testGPSQuiet()
+{
+	host_us = 0;
+	wifi_dns_ok = true;
+	udp_sent.clear();
+	udp_replies.clear();
+	Circum c;
+	GPSSim g (T0, 0);
+
+	// a fix a second, both checks called every 50 ms
+	long t = (long)ceil (g.trueNow());
+	for (int i = 0; i < 10; i++, t++) {
+	    host_us = g.localUs (t + 0.3);
+	    g.ss->send (GPSSim::fix (t));
+	    for (int j = 0; j < 20; j++, host_us += 50000) {
+		c.checkGPS();
+		c.checkNTP();
+	    }
+	}
+	CHECK (hostValue (hostValues (c), "GPS_TimeSrc") == "GPS");
+	CHECK (udp_sent.empty());
+
+	// nothing more arrives
+	while (udp_sent.empty() && host_us < g.localUs (t + 10)) {
+	    host_us += 50000;
+	    c.checkGPS();
+	    c.checkNTP();
+	}
+	CHECK (udp_sent.size() == 1);
+	CHECK (host_us <= g.localUs (t - 0.7 + 2.5));
+	if (udp_sent.empty())
+	    return;
+	double t1 = trueNow();
+	host_us += 20000;
+	udp_replies.push_back (reply (t1 + 0.008, t1 + 0.012));
+	c.checkNTP();
+	CHECK (hostValue (hostValues (c), "GPS_TimeSrc") == "NTP");
+	CHECK_NEAR (dtSecs (unixDT (trueNow()), c.now()), 0, 0.005);
+}
+
+int main()
+{
+	testReply();
+	testNoDNS();
+	testTimeouts();
+	testGPSQuiet();
+	return (hostDone ("test_ntp"));
+}
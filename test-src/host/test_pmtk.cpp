@@ -0,0 +1,110 @@
+/* Circum MTK receiver configuration: PMTK sentence framing and which acks are believed.
+ */
+
+#include "Circum.h"
+#include "gpssim.h"
+
+/* a receiver that answers each complete PMTK sentence using reply(cmd), which returns the
+ * whole answer or "" for none. every sentence received is kept in got.
+ */
+static std::vector<std::string> got;
+static std::function<std::string(int)> reply;
+
+static void receiver (SoftwareSerial *ss)
+{
+	ss->on_write = [ss]() {
+	    size_t n = ss->tx.size();
+	    if (n < 2 || ss->tx.compare (n-2, 2, "\r\n") != 0)
+		return;
+	    std::string line = ss->tx;
+	    ss->tx.clear();
+	    got.push_back (line);
+	    ss->send (reply (atoi (line.c_str() + 5)));
+	};
+}
+
+// return whether the configuration is shown as acked, ie GPS_Bps is not marked bad
+static bool configured (Circum &c)
+{
+	std::string bps = hostValue (hostValues (c), "GPS_Bps");
+	return (!bps.empty() && bps.back() != '!');
+}
+
+/* commands go out as $body*XX CRLF with XX the xor of body, both are acked
+ */
+static void testFraming()
+{
+	got.clear();
+	reply = [](int cmd) {
+	    char b[32];
+	    snprintf (b, sizeof(b), "PMTK001,%d,3", cmd);
+	    // some other traffic first
+	    return (GPSSim::fix (1710072000) + GPSSim::frame (b));
+	};
+	Circum c;
+	CHECK (got.size() == 2);
+	for (std::string &l : got) {
+	    size_t star = l.find ('*');
+	    CHECK (l[0] == '$' && star != std::string::npos);
+	    CHECK (l == GPSSim::frame (l.substr (1, star-1)));
+	}
+	CHECK (got.size() > 1 && got[1] == "$PMTK220,1000*1F\r\n");
+	CHECK (configured (c));
+}
+
+/* a corrupted ack is no ack
+ */
+static void testBadChecksum()
+{
+	reply = [](int cmd) {
+	    char b[32];
+	    snprintf (b, sizeof(b), "PMTK001,%d,3", cmd);
+	    std::string s = GPSSim::frame (b);
+	    s[s.find ('*') + 2] ^= 1;
+	    return (s);
+	};
+	Circum c;
+	CHECK (!configured (c));
+}
+
+/* an ack for another command, or one saying the command failed, is not success
+ */
+static void testWrongAck()
+{
+	reply = [](int cmd) {
+	    char b[32];
+	    snprintf (b, sizeof(b), "PMTK001,%d,3", cmd + 1);
+	    return (GPSSim::frame (b));
+	};
+	Circum c1;
+	CHECK (!configured (c1));
+
+	reply = [](int cmd) {
+	    char b[32];
+	    snprintf (b, sizeof(b), "PMTK001,%d,2", cmd);
+	    return (GPSSim::frame (b));
+	};
+	Circum c2;
+	CHECK (!configured (c2));
+}
+
+/* no receiver at all costs one PMTK_ACK_MS wait per command
+ */
+static void testSilent()
+{
+	reply = [](int) { return (std::string()); };
+	host_us = 0;
+	Circum c;
+	CHECK (!configured (c));
+	CHECK_NEAR (host_us*1e-6, 2.0, 0.1);
+}
+
+int main()
+{
+	SoftwareSerial::on_create = receiver;
+	testFraming();
+	testBadChecksum();
+	testWrongAck();
+	testSilent();
+	return (hostDone ("test_pmtk"));
+}
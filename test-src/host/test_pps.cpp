@@ -0,0 +1,95 @@
+/* Circum PPS discipline: lock and drift from simulated PPS edges and NMEA, and an edge that
+ * arrives while a stalled sentence is being read so NMEA moves the epoch past it.
+ */
+
+#include "Circum.h"
+#include "gpssim.h"
+
+#define	T0	1710072000.25			// 2024 Mar 10 12:00:00.25 UTC, arbitrary
+
+/* one simulated second from the edge at true whole second t: the edge, then the fix 300 ms
+ * later, with checkGPS() called every 50 ms as the main loop would.
+ */
+static void second (Circum &c, GPSSim &g, long t)
+{
+	host_us = g.localUs (t);
+	g.edge();
+	for (int i = 0; i < 20; i++) {
+	    host_us = g.localUs (t + 0.05*i);
+	    if (i == 6)
+		g.ss->send (GPSSim::fix (t));
+	    c.checkGPS();
+	}
+}
+
+/* a steady receiver: PPS locks, drift is measured, time is right to well within the TN precision
+ */
+static void testLock()
+{
+	host_us = 0;
+	Circum c;
+	GPSSim g (T0, 20e-6);
+
+	long t = (long)ceil (g.trueNow());
+	for (int i = 0; i < 100; i++)
+	    second (c, g, t++);
+
+	std::string v = hostValues (c);
+	CHECK (hostValue (v, "GPS_TimeSrc") == "GPS+PPS+");
+	CHECK_NEAR (atof (hostValue (v, "GPS_ClkDrift").c_str()), 20, 1);
+	CHECK_NEAR (atof (hostValue (v, "GPS_ClkOff").c_str()), 0, 25);
+	CHECK_NEAR (dtSecs (unixDT (g.trueNow()), c.now()), 0, 0.01);
+}
+
+/* the loop stalls past the next edge with a sentence waiting. the edge fires as the sentence
+ * is read, before PPS is locked, so NMEA sets the epoch just after an edge checkPPS has not seen.
+ * that edge must not throw the epoch off by the wrapped difference.
+ */
+static void testEdgeBeforeEpoch()
+{
+	host_us = 0;
+	Circum c;
+	GPSSim g (T0, 20e-6);
+
+	// first edge is seen but gives no interval yet
+	long t = (long)ceil (g.trueNow());
+	host_us = g.localUs (t);
+	g.edge();
+	c.checkGPS();
+
+	// its fix is queued but the loop is busy until the next edge fires during the read
+	g.ss->send (GPSSim::fix (t));
+	g.ss->on_read = [&]() {
+	    g.ss->on_read = nullptr;
+	    host_us = g.localUs (t + 1);
+	    g.edge();
+	    host_us += 500;
+	};
+	host_us = g.localUs (t + 1) - 100;
+	c.checkGPS();
+
+	// next call processes that edge, look at the time before the rest of the sentences arrive
+	DateTime after;
+	g.ss->on_read = [&]() {
+	    g.ss->on_read = nullptr;
+	    after = c.now();
+	};
+	host_us += 1000;
+	c.checkGPS();
+	CHECK_NEAR (dtSecs (unixDT (g.trueNow()), after), 0, 1.5);
+
+	// and it all settles once sentences arrive on time
+	t += 2;
+	for (int i = 0; i < 30; i++)
+	    second (c, g, t++);
+	std::string v = hostValues (c);
+	CHECK (hostValue (v, "GPS_TimeSrc") == "GPS+PPS+");
+	CHECK_NEAR (dtSecs (unixDT (g.trueNow()), c.now()), 0, 0.01);
+}
+
+int main()
+{
+	testLock();
+	testEdgeBeforeEpoch();
+	return (hostDone ("test_pps"));
+}
@@ -0,0 +1,230 @@
+/* Sensor frame math: az el to East North Up and back, including straight up and across it,
+ * boreENU() with known rotations, whole samples from a simulated BNO055 and sun alignment.
+ */
+
+#include "Sensor.h"
+#include "Control.h"
+#include "Webpage.h"
+#include "NV.h"
+#include "P13.h"
+#include "bnosim.h"
+
+// angle between vectors, degs, good for small angles too
+static double angle (const float a[3], const float b[3])
+{
+	double cx = (double)a[1]*b[2] - (double)a[2]*b[1];
+	double cy = (double)a[2]*b[0] - (double)a[0]*b[2];
+	double cz = (double)a[0]*b[1] - (double)a[1]*b[0];
+	double d = (double)a[0]*b[0] + (double)a[1]*b[1] + (double)a[2]*b[2];
+	return (atan2 (sqrt (cx*cx + cy*cy + cz*cz), d)*180/M_PI);
+}
+
+// a - b wrapped to -180 .. 180
+static double azDiff (double a, double b)
+{
+	double d = fmod (a - b, 360);
+	return (d > 180 ? d - 360 : (d < -180 ? d + 360 : d));
+}
+
+/* every az at every el comes back, az only matters where it is defined
+ */
+static void testRoundTrip()
+{
+	static const float els[] = {-80, -30, 0, 30, 60, 85, 89, 89.9F, 89.99F, 90};
+	for (float el : els) {
+	    for (float az = 0; az < 360; az += 7) {
+		float v[3], v2[3], az2, el2;
+		Sensor::azElENU (az, el, v);
+		Sensor::enuAzEl (v, az2, el2);
+		Sensor::azElENU (az2, el2, v2);
+		CHECK_NEAR (angle (v, v2), 0, 0.01);
+		CHECK_NEAR (el2, el, 0.001);
+		CHECK (az2 >= -180 && az2 <= 180);
+		if (el < 89)
+		    CHECK_NEAR (azDiff (az2, az), 0, 0.001);
+	    }
+	}
+
+	// exactly up has az 0
+	float up[3] = {0, 0, 1}, az, el;
+	Sensor::enuAzEl (up, az, el);
+	CHECK (az == 0 && el == 90);
+}
+
+/* along a great circle over the zenith el rises to 90 and falls again while az turns over by
+ * 180, and every point comes back to the same direction
+ */
+static void testThroughZenith()
+{
+	for (float a = 0; a < 360; a += 45) {
+	    for (float u = -10; u <= 10.01F; u += 0.5F) {
+		float r = radians (u), ar = radians (a);
+		float v[3] = {sinf(r)*sinf(ar), sinf(r)*cosf(ar), cosf(r)};
+		float az, el, v2[3];
+		Sensor::enuAzEl (v, az, el);
+		Sensor::azElENU (az, el, v2);
+		CHECK_NEAR (angle (v, v2), 0, 0.01);
+		CHECK_NEAR (el, 90 - fabsf (u), 0.01);
+		if (u < -0.1F)
+		    CHECK_NEAR (azDiff (az, a + 180), 0, 0.01);
+		else if (u > 0.1F)
+		    CHECK_NEAR (azDiff (az, a), 0, 0.01);
+	    }
+	}
+}
+
+/* known rotations of known vectors
+ */
+static void testBoreENU()
+{
+	const float c = sqrtf (0.5F);
+	float v[3];
+
+	// identity
+	float b[3] = {0, -1, 0};
+	Sensor::boreENU (imu::Quaternion (1, 0, 0, 0), b, v);
+	CHECK_NEAR (v[0], 0, 1e-6); CHECK_NEAR (v[1], -1, 1e-6); CHECK_NEAR (v[2], 0, 1e-6);
+
+	// 90 degs about Up turns East to North
+	float e[3] = {1, 0, 0};
+	Sensor::boreENU (imu::Quaternion (c, 0, 0, c), e, v);
+	CHECK_NEAR (v[0], 0, 1e-6); CHECK_NEAR (v[1], 1, 1e-6); CHECK_NEAR (v[2], 0, 1e-6);
+
+	// 90 degs about East tips North up
+	float n[3] = {0, 1, 0};
+	Sensor::boreENU (imu::Quaternion (c, c, 0, 0), n, v);
+	CHECK_NEAR (v[0], 0, 1e-6); CHECK_NEAR (v[1], 0, 1e-6); CHECK_NEAR (v[2], 1, 1e-6);
+
+	// a quaternion a few register counts long still gives a unit vector
+	Sensor::boreENU (imu::Quaternion (1.001F*c, 1.001F*c, 0, 0), n, v);
+	CHECK_NEAR (sqrtf (v[0]*v[0] + v[1]*v[1] + v[2]*v[2]), 1, 1e-6);
+	CHECK_NEAR (v[2], 1, 1e-5);
+
+	// an arbitrary rotation against its matrix
+	float w = 0.5F, x = 0.1F, y = -0.7F, z = 0.3F;
+	float r = sqrtf (w*w + x*x + y*y + z*z);
+	w /= r; x /= r; y /= r; z /= r;
+	float R[3][3] = {
+	    {1 - 2*(y*y + z*z), 2*(x*y - w*z), 2*(x*z + w*y)},
+	    {2*(x*y + w*z), 1 - 2*(x*x + z*z), 2*(y*z - w*x)},
+	    {2*(x*z - w*y), 2*(y*z + w*x), 1 - 2*(x*x + y*y)},
+	};
+	float p[3] = {0.3F, -0.5F, 0.81F};
+	Sensor::boreENU (imu::Quaternion (w, x, y, z), p, v);
+	float pr = sqrtf (p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+	for (int i = 0; i < 3; i++)
+	    CHECK_NEAR (v[i], (R[i][0]*p[0] + R[i][1]*p[1] + R[i][2]*p[2])/pr, 1e-5);
+}
+
+/* whole samples: the sensor reports where the simulated antenna points, plus magnetic
+ * declination, whatever the roll and right up to the zenith
+ */
+static void testSample()
+{
+	BNOSim bno;
+	bno.attach();
+	Sensor s;
+
+	static const float poses[][3] = {
+	    {0, 0, 0}, {10, 20, 0}, {135, 45, 30}, {359.5F, 10, -20}, {250, 80, 90},
+	    {45, 89.5F, 0}, {225, 89.5F, 45}, {300, -10, 10},
+	};
+	for (auto &p : poses) {
+	    bno.point (p[0], p[1], p[2]);
+	    host_us += 50000;
+	    s.update();
+	    float az, el;
+	    CHECK (s.getAzEl (&az, &el) < 100);
+	    CHECK_NEAR (el, p[1], 0.05);
+	    CHECK_NEAR (azDiff (az, p[0] + circum->magdeclination), 0, p[1] > 89 ? 5 : 0.05);
+	}
+}
+
+/* sun alignment: a board mounted with the boresight off body -Y and a heading error is put
+ * on the sun at several times with the antenna rolled differently each time. the solved
+ * boresight and heading then put the pointing on the sun at another time and roll.
+ */
+static void sunOn (BNOSim &bno, Sensor &s, const char *utc, double roll, const double bore[3],
+    double head, float &sun_az, float &sun_el)
+{
+	char n1[] = "GPS_Date", v1[] = "2024 6 21", n2[] = "GPS_UTC", v2[32];
+	strcpy (v2, utc);
+	circum->overrideValue (n1, v1);
+	circum->overrideValue (n2, v2);
+
+	Sun sun;
+	DateTime now (circum->now());
+	sun.predict (now);
+	sun.topo (circum->observer(), sun_el, sun_az);
+
+	// the sensor reads magnetic az less the heading error
+	bno.point (sun_az - circum->magdeclination - head, sun_el, roll, bore);
+	host_us += 50000;
+	s.update();
+}
+
+static void testSunAlign()
+{
+	BNOSim bno;
+	bno.attach();
+	nv->get();
+	nv->sunalign_ok = 0;
+	nv->put();
+	Sensor s;
+
+	const double bore[3] = {0.08/1.005, -1/1.005, 0.06/1.005};	// about 5.7 degs off -Y
+	const double head = 4;
+	static const struct {
+	    const char *utc;
+	    double roll;
+	} pts[] = {
+	    {"15 0 0", 0}, {"16 30 0", 40}, {"18 0 0", -30}, {"20 0 0", 90}, {"22 0 0", -60},
+	};
+	char n[] = "SS_SunCal";
+	float sun_az, sun_el;
+	for (auto &p : pts) {
+	    sunOn (bno, s, p.utc, p.roll, bore, head, sun_az, sun_el);
+	    char v[] = "Add";
+	    s.overrideValue (n, v);
+	}
+	char v[] = "Solve";
+	s.overrideValue (n, v);
+
+	std::string cal = hostValue (hostValues (s), "SS_SunCal");
+	CHECK (cal.find ("5 pts, On rms ") == 0);
+	CHECK_NEAR (atof (cal.c_str() + 14), 0, 0.05);
+	CHECK (nv->sunalign_ok == NV::VALID);
+	CHECK_NEAR (nv->sunhead, head, 0.1);
+	float b[3] = {(float)bore[0], (float)bore[1], (float)bore[2]};
+	CHECK_NEAR (angle (nv->sunbore, b), 0, 0.05);
+
+	// another time and roll
+	sunOn (bno, s, "23 0 0", 150, bore, head, sun_az, sun_el);
+	float az, el;
+	s.getAzEl (&az, &el);
+	CHECK_NEAR (el, sun_el, 0.05);
+	CHECK_NEAR (azDiff (az, sun_az), 0, 0.05);
+
+	// and a fresh Sensor gets them from EEPROM
+	Sensor s2;
+	host_us += 50000;
+	s2.update();
+	s2.getAzEl (&az, &el);
+	CHECK_NEAR (el, sun_el, 0.05);
+	CHECK_NEAR (azDiff (az, sun_az), 0, 0.05);
+}
+
+int main()
+{
+	nv = new NV();
+	control = new Control();
+	webpage = new Webpage();
+	circum = new Circum();
+
+	testRoundTrip();
+	testThroughZenith();
+	testBoreENU();
+	testSample();
+	testSunAlign();
+	return (hostDone ("test_sensor"));
+}
@@ -0,0 +1,136 @@
+/* host test of Target: with time running through real passes of a real orbit, the gimbal is sent
+ * the rest of each pass as it rises and the whole of the next as it sets, from track() alone.
+ */
+
+#include "host.h"
+#include "NV.h"
+#include "Circum.h"
+#include "Target.h"
+#include "Gimbal.h"
+#include "Sensor.h"
+#include "Webpage.h"
+#include "P13.h"
+
+extern int gimbal_plans;
+extern SkyPoint gimbal_path[20];
+extern uint8_t gimbal_npath;
+extern bool gimbal_up;
+
+static char tle0[] = "ISS (ZARYA)";
+static char tle1[] = "1 25544U 98067A   24172.50000000  .00016717  00000-0  30119-3 0  9990";
+static char tle2[] = "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.49815338 46220";
+
+#define	STEP_MS		500		// as often as Control tracks
+#define	LATE_S		5		// most secs after rise or set for the new plan
+
+/* where the satellite is now, found apart from Target
+ */
+static void satAzEl (Satellite &sat, float &az, float &el)
+{
+	DateTime now (circum->now());
+	float range, rate;
+	sat.predict (now);
+	sat.topo (circum->observer(), el, az, range, rate);
+}
+
+static double azDiff (double a, double b)
+{
+	double d = fmod (a - b + 720, 360);
+	return (d > 180 ? d - 360 : d);
+}
+
+/* a day of passes: each rise and set brings exactly one new plan, soon after, whether or not a
+ * page polls Target. a rising plan is the rest of the pass and marked up, so the gimbal keeps the
+ * plan it has; a setting plan is the whole of the next pass from its rise, not up, so the gimbal
+ * replaces the one just done. each setting plan starts where the next pass really rises.
+ */
+static void testPassRefresh()
+{
+	char n1[] = "GPS_Lat", v1[] = "40", n2[] = "GPS_Long", v2[] = "-105";
+	char n3[] = "GPS_Date", v3[] = "2024 6 21", n4[] = "GPS_UTC", v4[] = "0 0 0";
+	circum->overrideValue (n1, v1);
+	circum->overrideValue (n2, v2);
+	circum->overrideValue (n3, v3);
+	circum->overrideValue (n4, v4);
+	target->setTLE (tle0, tle1, tle2);
+	Satellite sat;
+	sat.tle (tle1, tle2);
+
+	int plans = gimbal_plans;
+	float az, el;
+	satAzEl (sat, az, el);
+	bool was_up = el > 0;
+	bool first = true;
+	int rises = 0, sets = 0, late = 0;
+	long since = -1;			// ms since the last rise or set, -1 once planned
+	float rise_az = 0;			// where the latest setting plan has the next rise
+	bool rise_known = false;
+
+	for (long ms = 0; ms < 24*3600*1000L; ms += STEP_MS) {
+	    host_us += STEP_MS*1000;
+	    circum->checkRecompute();
+	    target->track();
+	    if (ms % 10000 == 0)
+		hostValues (*target);
+
+	    satAzEl (sat, az, el);
+	    bool up = el > 0;
+	    if (up != was_up) {
+		CHECK (since < 0);		// the previous event was planned
+		since = 0;
+		if (up) {
+		    rises++;
+		    if (rise_known)
+			CHECK_NEAR (azDiff (az, rise_az), 0, 1);
+		} else
+		    sets++;
+		was_up = up;
+	    } else if (since >= 0)
+		since += STEP_MS;
+
+	    if (gimbal_plans == plans)
+		continue;
+	    plans = gimbal_plans;
+	    CHECK (gimbal_npath > 2);
+	    if (first) {
+		// from the new TLE
+		first = false;
+		CHECK (gimbal_up == up);
+	    } else {
+		CHECK (since >= 0 && since <= LATE_S*1000);
+		CHECK (gimbal_up == up);
+		if (since > LATE_S*1000 || since < 0)
+		    late++;
+	    }
+	    since = -1;
+
+	    // up starts here, not up starts at the rise. both end at the set
+	    if (up)
+		CHECK_NEAR (gimbal_path[0].el, el, 1);
+	    else {
+		CHECK_NEAR (gimbal_path[0].el, 0, 1);
+		rise_az = gimbal_path[0].az;
+		rise_known = true;
+	    }
+	    CHECK_NEAR (gimbal_path[gimbal_npath-1].el, 0, 1);
+	    for (uint8_t i = 0; i < gimbal_npath; i++)
+		CHECK (gimbal_path[i].el > -1);
+	}
+
+	CHECK (rises >= 3 && sets >= 3);
+	CHECK (late == 0);
+	CHECK (since < 0);
+}
+
+int main()
+{
+	nv = new NV();
+	webpage = new Webpage();
+	circum = new Circum();
+	gimbal = new Gimbal();
+	sensor = new Sensor();
+	target = new Target();
+
+	testPassRefresh();
+	return (hostDone ("test_target"));
+}
@@ -0,0 +1,275 @@
+/* UBX parser: frame building, NAV-PVT decoding at the receiver's own byte offsets, rejection
+ * of corrupted frames, and bytes and CPU per fix against TinyGPS on the same minute of fixes.
+ */
+
+#include "UBX.h"
+#include <TinyGPS.h>
+#include "host.h"
+
+#include <chrono>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+// store v little-endian at payload offset i
+static void put (Bytes &p, size_t i, uint32_t v, int n)
+{
+	for (int k = 0; k < n; k++)
+	    p[i+k] = (v >> (8*k)) & 0xff;
+}
+
+/* a NAV-PVT payload laid out by the u-blox protocol description, not by UBX::NavPVT
+ */
+static Bytes pvt (uint8_t valid, uint8_t flags)
+{
+	Bytes p(92, 0);
+	put (p, 4, 2024, 2);			// year
+	p[6] = 3;				// month
+	p[7] = 10;				// day
+	p[8] = 12;				// hour
+	p[9] = 34;				// min
+	p[10] = 56;				// sec
+	p[11] = valid;
+	put (p, 16, 345000000, 4);		// nano
+	p[20] = 3;				// fixType
+	p[21] = flags;
+	p[23] = 9;				// numSV
+	put (p, 24, (uint32_t)-1105000012, 4);	// lon, 1e-7 degs
+	put (p, 28, (uint32_t)-338688004, 4);	// lat
+	put (p, 36, 123456, 4);			// hMSL, mm
+	put (p, 76, 157, 2);			// pDOP
+	return (p);
+}
+
+// frame body with UBX::frame()
+static Bytes frame (uint8_t cls, uint8_t id, const Bytes &body)
+{
+	uint8_t buf[128];
+	uint8_t n = UBX::frame (cls, id, body.data(), body.size(), buf, sizeof(buf));
+	return (Bytes (buf, buf+n));
+}
+
+// feed bytes, return how many times encode() reported a new solution and whether the last byte did
+static int feed (UBX &u, const Bytes &b, bool *last = NULL)
+{
+	int n = 0;
+	bool r = false;
+	for (uint8_t c : b) {
+	    r = u.encode (c);
+	    n += r;
+	}
+	if (last)
+	    *last = r;
+	return (n);
+}
+
+/* the known CFG-RATE 1 Hz frame, and a buffer too small
+ */
+static void testFrame()
+{
+	Bytes f = frame (UBX::CLS_CFG, UBX::ID_CFG_RATE, Bytes {0xE8, 0x03, 0x01, 0x00, 0x01, 0x00});
+	Bytes want {0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xE8, 0x03, 0x01, 0x00, 0x01, 0x00, 0x01, 0x39};
+	CHECK (f == want);
+
+	uint8_t buf[10];
+	uint8_t body[6] = {0};
+	CHECK (UBX::frame (UBX::CLS_CFG, UBX::ID_CFG_RATE, body, sizeof(body), buf, sizeof(buf)) == 0);
+}
+
+/* a good solution, after noise and a doubled sync byte
+ */
+static void testDecode()
+{
+	host_us = 5000000;
+	UBX u;
+	Bytes b {0x00, 0x62, 0xB5, 0x24, 0xB5};
+	Bytes f = frame (UBX::CLS_NAV, UBX::ID_NAV_PVT, pvt (7, 1));
+	b.insert (b.end(), f.begin(), f.end());
+	bool last;
+	CHECK (feed (u, b, &last) == 1 && last);
+
+	host_us += 250000;
+	int y; byte mo, d, h, mi, s, cs;
+	unsigned long age;
+	u.crack_datetime (&y, &mo, &d, &h, &mi, &s, &cs, &age);
+	CHECK (y == 2024 && mo == 3 && d == 10);
+	CHECK (h == 12 && mi == 34 && s == 56 && cs == 34);
+	CHECK (age == 250);
+
+	long lat, lng;
+	u.get_position (&lat, &lng, &age);
+	CHECK (lat == -33868800 && lng == -110500001);
+	CHECK (age == 250);
+	CHECK (u.altitude() == 12345);
+	CHECK (u.satellites() == 9);
+	CHECK (u.pdop() == 157);
+	CHECK (u.fix_mode() == 3);
+}
+
+/* nothing from a frame with a bad checksum or a corrupted payload, and the parser recovers
+ */
+static void testBadChecksum()
+{
+	UBX u;
+	Bytes f = frame (UBX::CLS_NAV, UBX::ID_NAV_PVT, pvt (7, 1));
+
+	Bytes bad = f;
+	bad.back() ^= 0x01;
+	CHECK (feed (u, bad) == 0);
+	bad = f;
+	bad[bad.size()-2] ^= 0x80;
+	CHECK (feed (u, bad) == 0);
+	bad = f;
+	bad[6+10] = 57;				// seconds changed, checksum not
+	CHECK (feed (u, bad) == 0);
+
+	unsigned long date, time, age;
+	u.get_datetime (&date, &time, &age);
+	CHECK (age == UBX::GPS_INVALID_AGE);
+	long lat, lng;
+	u.get_position (&lat, &lng, &age);
+	CHECK (lat == UBX::GPS_INVALID_ANGLE && age == UBX::GPS_INVALID_AGE);
+
+	CHECK (feed (u, f) == 1);
+	u.get_datetime (&date, &time, &age);
+	CHECK (date == 100324 && time == 12345634);
+}
+
+/* time is not used until the receiver says it is valid, position until the fix is ok
+ */
+static void testInvalid()
+{
+	UBX u;
+	CHECK (feed (u, frame (UBX::CLS_NAV, UBX::ID_NAV_PVT, pvt (1, 0))) == 1);
+	unsigned long date, time, age;
+	u.get_datetime (&date, &time, &age);
+	CHECK (age == UBX::GPS_INVALID_AGE);
+	long lat, lng;
+	u.get_position (&lat, &lng, &age);
+	CHECK (age == UBX::GPS_INVALID_AGE);
+}
+
+/* ACK and NAK of the message we are waiting for, and not of others
+ */
+static void testAck()
+{
+	UBX u;
+	CHECK (u.acked (UBX::CLS_CFG, UBX::ID_CFG_RATE) == -1);
+	CHECK (feed (u, frame (UBX::CLS_ACK, UBX::ID_ACK_ACK, Bytes {UBX::CLS_CFG, UBX::ID_CFG_RATE})) == 0);
+	CHECK (u.acked (UBX::CLS_CFG, UBX::ID_CFG_RATE) == 1);
+	CHECK (u.acked (UBX::CLS_CFG, UBX::ID_CFG_MSG) == -1);
+
+	u.clearAck();
+	CHECK (u.acked (UBX::CLS_CFG, UBX::ID_CFG_RATE) == -1);
+	feed (u, frame (UBX::CLS_ACK, UBX::ID_ACK_NAK, Bytes {UBX::CLS_CFG, UBX::ID_CFG_MSG}));
+	CHECK (u.acked (UBX::CLS_CFG, UBX::ID_CFG_MSG) == 0);
+
+	// a corrupted ACK is not one
+	u.clearAck();
+	Bytes bad = frame (UBX::CLS_ACK, UBX::ID_ACK_ACK, Bytes {UBX::CLS_CFG, UBX::ID_CFG_RATE});
+	bad.back() ^= 0x01;
+	feed (u, bad);
+	CHECK (u.acked (UBX::CLS_CFG, UBX::ID_CFG_RATE) == -1);
+}
+
+// return the contents of the given fixture file
+static Bytes fixture (const char *fn)
+{
+	Bytes b;
+	FILE *fp = fopen (fn, "rb");
+	CHECK (fp != NULL);
+	if (!fp)
+	    return (b);
+	int c;
+	while ((c = fgetc (fp)) != EOF)
+	    b.push_back (c);
+	fclose (fp);
+	return (b);
+}
+
+// bytes of the sentences in nmea whose tags are listed, such as "GPRMC GPGGA"
+static size_t sentenceBytes (const Bytes &nmea, const char *tags)
+{
+	size_t n = 0;
+	for (size_t i = 0; i < nmea.size(); ) {
+	    size_t e = i;
+	    while (e < nmea.size() && nmea[e] != '\n')
+		e++;
+	    if (strstr (tags, std::string (nmea.begin() + i + 1, nmea.begin() + i + 6).c_str()))
+		n += e + 1 - i;
+	    i = e + 1;
+	}
+	return (n);
+}
+
+// average ns to encode all of b, over enough passes to take some time
+template <typename P> static double encodeNs (const Bytes &b)
+{
+	const int REPS = 200;
+	int sum = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (int r = 0; r < REPS; r++) {
+	    P p;
+	    for (uint8_t c : b)
+		sum += p.encode (c);
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	CHECK (sum > 0);
+	return (std::chrono::duration<double, std::nano>(t1 - t0).count()/REPS);
+}
+
+/* the same 60 one second fixes as an MTK receiver sends them as Circum configures it, RMC, GGA,
+ * GSA and ZDA each second and GSV each 5th, and as a u-blox sends them in NAV-PVT. both parsers
+ * end on the same fix; NAV-PVT takes well under half the bytes and less CPU per fix.
+ */
+static void testBenchmark()
+{
+	const int NFIX = 60;
+	Bytes nmea = fixture ("fixtures/mtk_60s.nmea");
+	Bytes pvt = fixture ("fixtures/ubx_60s.bin");
+	if (nmea.empty() || pvt.empty())
+	    return;
+
+	// both streams hold the same fixes
+	TinyGPS t;
+	int sentences = 0;
+	for (uint8_t c : nmea)
+	    sentences += t.encode (c);
+	UBX u;
+	CHECK (feed (u, pvt) == NFIX);
+	unsigned long t_date, t_time, u_date, u_time;
+	t.get_datetime (&t_date, &t_time);
+	u.get_datetime (&u_date, &u_time);
+	CHECK (t_date == 100324 && u_date == 100324);
+	CHECK (t_time == 12005900 && u_time == 12005900);
+	long t_lat, t_lng, u_lat, u_lng;
+	t.get_position (&t_lat, &t_lng);
+	u.get_position (&u_lat, &u_lng);
+	CHECK (labs (t_lat - u_lat) <= 1 && labs (t_lng - u_lng) <= 1);
+	CHECK (t.altitude() == u.altitude());
+
+	double nmea_bytes = (double)nmea.size()/NFIX;
+	double min_bytes = (double)sentenceBytes (nmea, "GPRMC GPGGA")/NFIX;
+	double pvt_bytes = (double)pvt.size()/NFIX;
+	double nmea_ns = encodeNs<TinyGPS> (nmea)/NFIX;
+	double pvt_ns = encodeNs<UBX> (pvt)/NFIX;
+	printf ("per fix: NMEA %.0f bytes (RMC+GGA alone %.0f) %.0f ns, NAV-PVT %.0f bytes %.0f ns\n",
+			nmea_bytes, min_bytes, nmea_ns, pvt_bytes, pvt_ns);
+	printf ("NAV-PVT/NMEA: bytes %.2f (%.2f of RMC+GGA), CPU %.2f\n",
+			pvt_bytes/nmea_bytes, pvt_bytes/min_bytes, pvt_ns/nmea_ns);
+	CHECK (sentences == NFIX*4 + NFIX/5);	// a GSV set completes once
+	CHECK (pvt_bytes < 0.5*nmea_bytes);
+	CHECK (pvt_bytes < min_bytes);
+	CHECK (pvt_ns < 0.5*nmea_ns);
+}
+
+int main()
+{
+	testFrame();
+	testDecode();
+	testBadChecksum();
+	testInvalid();
+	testAck();
+	testBenchmark();
+	return (hostDone ("test_ubx"));
+}